@@ -0,0 +1,143 @@
+﻿#pragma once
+// ==================== 分配下界启发函数 ====================
+// 目标状态中每种颜色独占一个试管，其余试管为空。固定"颜色 -> 目标试管"的分配后，
+// 每个试管必须倒出的次数有下界；对所有分配取最小（匈牙利算法）即为可采纳的启发值。
+//
+// 代价按"倒出次数"而非单位数计：一次倒水可移动整段同色水，按单位计会高估。
+// 试管 t 分配给颜色 c 时：
+//   - 若 t 的底色为 c，底段可以留下，其上每个色块至少要各倒出一次（不同色块无法在原试管内合并）；
+//   - 否则 t 中每个色块都要倒出一次；
+//   - 若 c 的全部水都在 t 中但不全在底段，倒出后还需再倒回来，额外 +1
+//     （倒回的那次不携带任何其他试管的原有水，不会与上面计入的倒出重合）。
+// 分配给"空"的试管代价为其色块数。不同试管的倒出互不重合，各列代价之和即为下界。
+//
+// 一次倒水只改变源、目标两个试管，对应矩阵中的两列；颜色位置掩码也只有倒出的颜色会变，
+// 其"额外 +1"只可能落在这两列上。因此子状态的矩阵由父状态矩阵复制后更新两列得到，无需重建。
+#include "PackedState.h"
+
+class AssignmentMatrix {
+public:
+    AssignmentMatrix() : size(0), valid(false) {}
+
+    // 为初始状态建立完整矩阵；颜色集合在搜索中不变，行的颜色映射只在此建立一次
+    void build(const PackedState& state, const StateMetrics& metrics) {
+        size = state.numTubes;
+        int rows = 0;
+        for (int c = 1; c <= PACKED_MAX_COLOR; c++) {
+            if (metrics.colorTubes[c] == 0) continue;
+            if (rows == size) {
+                valid = false;  // 颜色数多于试管数，必然无解
+                return;
+            }
+            rowColor[rows++] = (uint8_t)c;
+        }
+        for (int r = rows; r < size; r++) {
+            rowColor[r] = 0;    // 0 表示最终为空的试管
+        }
+        valid = true;
+        for (int t = 0; t < size; t++) {
+            updateColumn(state, metrics, t);
+        }
+    }
+
+    // 倒水 from -> to 之后，用新状态更新受影响的两列
+    void applyPour(const PackedState& after, const StateMetrics& metrics, int from, int to) {
+        if (!valid) return;
+        updateColumn(after, metrics, from);
+        updateColumn(after, metrics, to);
+    }
+
+    // 最小分配代价；颜色数超过试管数时退化为颜色块启发值
+    int bound(const StateMetrics& metrics) const {
+        if (!valid) return metrics.heuristic(HEURISTIC_BLOCKS);
+        return solve();
+    }
+
+private:
+    int size;
+    bool valid;
+    uint8_t rowColor[PACKED_MAX_TUBES];
+    int8_t cost[PACKED_MAX_TUBES][PACKED_MAX_TUBES];   // [行(颜色)][列(试管)]
+
+    void updateColumn(const PackedState& state, const StateMetrics& metrics, int t) {
+        int tubeSize = state.tubeSize(t);
+        int blocks = tubeSize == 0 ? 0 : state.colorChanges(t) + 1;
+        int bottom = tubeSize == 0 ? 0 : state.colorAt(t, 0);
+        uint16_t tubeBit = (uint16_t)(1u << t);
+
+        for (int r = 0; r < size; r++) {
+            int c = rowColor[r];
+            int value = blocks;
+            if (c != 0) {
+                int kept = c == bottom ? state.bottomSegmentSize(t) : 0;
+                if (kept > 0) value--;
+                if (metrics.colorTubes[c] == tubeBit &&
+                    nibblesContain(state.tubes[t] >> (4 * kept), tubeSize - kept, c)) {
+                    value++;
+                }
+            }
+            cost[r][t] = (int8_t)value;
+        }
+    }
+
+    // 匈牙利算法（势函数 + 增广路），O(n^3)，n 不超过 16
+    int solve() const {
+        const int INF = 1 << 20;
+        int u[PACKED_MAX_TUBES + 1] = { 0 };
+        int v[PACKED_MAX_TUBES + 1] = { 0 };
+        int match[PACKED_MAX_TUBES + 1] = { 0 };    // 列 -> 行（1 起始，0 表示未匹配）
+        int way[PACKED_MAX_TUBES + 1] = { 0 };
+
+        for (int row = 1; row <= size; row++) {
+            int minSlack[PACKED_MAX_TUBES + 1];
+            bool used[PACKED_MAX_TUBES + 1];
+            for (int j = 0; j <= size; j++) {
+                minSlack[j] = INF;
+                used[j] = false;
+            }
+
+            match[0] = row;
+            int col = 0;
+            do {
+                used[col] = true;
+                int i = match[col];
+                int delta = INF;
+                int nextCol = 0;
+                for (int j = 1; j <= size; j++) {
+                    if (used[j]) continue;
+                    int slack = cost[i - 1][j - 1] - u[i] - v[j];
+                    if (slack < minSlack[j]) {
+                        minSlack[j] = slack;
+                        way[j] = col;
+                    }
+                    if (minSlack[j] < delta) {
+                        delta = minSlack[j];
+                        nextCol = j;
+                    }
+                }
+                for (int j = 0; j <= size; j++) {
+                    if (used[j]) {
+                        u[match[j]] += delta;
+                        v[j] -= delta;
+                    }
+                    else {
+                        minSlack[j] -= delta;
+                    }
+                }
+                col = nextCol;
+            } while (match[col] != 0);
+
+            do {
+                int prevCol = way[col];
+                match[col] = match[prevCol];
+                col = prevCol;
+            } while (col != 0);
+        }
+
+        int total = 0;
+        for (int j = 1; j <= size; j++) {
+            total += cost[match[j] - 1][j - 1];
+        }
+        return total;
+    }
+};
@@ -0,0 +1,619 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+// ==================== 命令行批量求解程序 ====================
+// 从文件读取大量关卡，多线程并行求解，输出解法与每个关卡的统计信息。
+//
+// 输入格式：每行一个关卡，'#' 开头的行为注释
+//   <容量> <试管1> <试管2> ...
+//   每个试管为自底向上的颜色序列（逗号分隔），空试管写 "-"
+//   例: 4 1,2,1,2 2,1,2,1 - -
+//
+// 输出：
+//   解法文件   每行: <关卡号>\t<状态>\t<步数>\t<移动序列，如 "1>3 2>3">
+//   统计文件   CSV: id,algorithm,heuristic,status,steps,states_explored,max_memory,time_ms,peak_kb,visited,load_factor,avg_probes,pruned_uniform,pruned_empty,pruned_undo,pruned_completed,pruned_dead,threads,speedup,bound,disk_kb,mem_budget_kb,mem_action
+//              heuristic 列仅对 A* / IDA* 有意义；--compare-heuristics 时每个关卡按各启发函数各输出一行
+//              bound 列为 ARA* 的次优界（解长 / 最优解长的上界），其他算法为 "-"
+//              disk_kb 列为外存 BFS 临时文件的峰值大小，其他算法为 0
+//              mem_action 列为触发内存预算后的处理：none / abort / fallback（已改用 IDA*）/ compact
+//              -a Portfolio 时先输出组合结果一行，再按成员各输出一行（algorithm 列为成员名，status 可为 cancelled）
+//   语料库     --corpus-out 时另把关卡与解写成二进制语料库（见 LevelCorpus.h），-i 也可直接读语料库
+#include "SolverCore.h"
+#include "LevelCorpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+using namespace chrono;
+
+struct BatchOptions {
+    string inputPath;
+    string solutionPath;
+    string statsPath;
+    string corpusPath;              // 二进制语料库输出文件，空表示不输出
+    string algorithm;
+    int threads;
+    size_t expectedStates;
+    bool canonicalizeTubes;
+    bool canonicalizeColors;
+    unsigned pruneRules;
+    int heuristic;
+    bool compareHeuristics;         // 对每个关卡用全部启发函数各跑一次 A*
+    size_t transpositionBytes;
+    int transpositionPolicy;
+    bool layeredBFS;
+    bool externalBFS;
+    string scratchDirectory;        // 外存 BFS 的临时文件目录
+    size_t externalMemoryBytes;     // 外存 BFS 的内存预算
+    long long memoryBudgetBytes;    // 每个关卡的内存预算，0 表示不限
+    int memoryAction;               // 超出预算时的处理
+    size_t presolveStates;          // 求解前无解判定穷举的状态数上限，0 表示不做判定
+    int searchThreads;              // 单个关卡内部的搜索线程数
+    double heuristicWeight;         // A* 启发权重
+    int portfolioQuality;           // 组合求解接受的解的质量
+    double anytimeWeight;           // ARA* 初始权重
+    double anytimeWeightStep;       // ARA* 每轮降低的权重
+    long long timeLimitMs;          // ARA* 单个关卡的时间上限
+    int beamWidth;                  // 束搜索每层保留的状态数
+    int beamRestarts;               // 束搜索失败后加宽重试的次数
+
+    BatchOptions() : algorithm("A*"), threads(0), expectedStates(0), canonicalizeTubes(true),
+        canonicalizeColors(false), pruneRules(PRUNE_ALL), heuristic(HEURISTIC_BLOCKS), compareHeuristics(false),
+        transpositionBytes(64u << 20), transpositionPolicy(REPLACE_DEEPER), layeredBFS(false), externalBFS(false),
+        externalMemoryBytes(256u << 20), memoryBudgetBytes(0), memoryAction(MEMORY_ABORT), presolveStates(256), searchThreads(1),
+        heuristicWeight(1.0), portfolioQuality(QUALITY_OPTIMAL), anytimeWeight(3.0), anytimeWeightStep(0.5),
+        timeLimitMs(0), beamWidth(1000), beamRestarts(2) {}
+};
+
+// 单个关卡的任务与结果
+struct BatchJob {
+    int id;                 // 关卡号（输入文件中的序号，从1开始）
+    GameState start;
+    string parseError;      // 非空表示该行解析失败
+
+    // 结果
+    bool done;
+    bool solved;
+    vector<string> moves;
+    vector<CorpusMove> corpusMoves; // 解的二进制形式，写语料库用
+    AlgorithmStats stats;
+    StateTableStats tableStats;
+    string reason;
+    int threadsUsed;
+    double speedup;
+    double bound;           // ARA* 次优界，0 表示未计算
+    long long diskBytes;    // 外存 BFS 临时文件峰值
+
+    // 组合求解各成员的结果
+    vector<AlgorithmStats> portfolioStats;
+    int portfolioWinner;
+
+    // 对比模式下各启发函数的结果
+    AlgorithmStats heuristicStats[HEURISTIC_COUNT];
+    StateTableStats heuristicTableStats[HEURISTIC_COUNT];
+};
+
+static void printUsage(const char* prog) {
+    printf("用法: %s -i <关卡文件> [-o <解法文件>] [-s <统计文件>] [-a BFS|DFS|A*|IDA*|ARA*|Beam|Portfolio] [-j <线程数>]\n", prog);
+    printf("  -i, --input      输入关卡文件\n");
+    printf("  -o, --output     解法输出文件（默认标准输出）\n");
+    printf("  -s, --stats      统计 CSV 输出文件（默认不输出）\n");
+    printf("  --corpus-out <文件> 另把关卡与解写成二进制语料库；-i 给出的若是语料库则直接映射读取\n");
+    printf("  -a, --algorithm  求解算法，默认 A*\n");
+    printf("  -j, --threads    工作线程数，默认使用全部核心\n");
+    printf("  --expected-states 预计每个关卡的状态数，用于预分配已访问表\n");
+    printf("  --no-canonical   去重时区分试管排列顺序\n");
+    printf("  --color-symmetry 去重时忽略颜色编号\n");
+    printf("  --prune <规则>   启用的剪枝规则: all / none / 以逗号分隔的编号 0-%d\n", PRUNE_RULE_COUNT - 1);
+    for (int i = 0; i < PRUNE_RULE_COUNT; i++) {
+        printf("                   %d = %s\n", i, GetPruneRuleName(i));
+    }
+    printf("  --heuristic <编号> A* 启发函数，默认 %d\n", HEURISTIC_BLOCKS);
+    for (int i = 0; i < HEURISTIC_COUNT; i++) {
+        printf("                   %d = %s\n", i, GetHeuristicName(i));
+    }
+    printf("  --compare-heuristics 用全部启发函数分别求解每个关卡并对比扩展状态数（使用 A*）\n");
+    printf("  --weight <w>     A* 启发权重，默认 1；大于1时为加权 A*，解不保证最优\n");
+    printf("  --anytime-weight <w> ARA* 初始启发权重，默认 3\n");
+    printf("  --anytime-step <d>   ARA* 每轮降低的权重，默认 0.5\n");
+    printf("  --time-limit <ms>    ARA* 每个关卡的时间上限，超时输出当前最好的解，默认不限\n");
+    printf("  --beam-width <n>     束搜索每层保留的状态数，默认 1000\n");
+    printf("  --beam-restarts <n>  束搜索失败后宽度翻倍重试的次数，默认 2\n");
+    printf("  --quality optimal|any  -a Portfolio 时接受的解：只接受最优成员的解 / 任一成员的解，默认 optimal\n");
+    printf("  --layered        BFS 按层同步，每层排序后批量去重\n");
+    printf("  --search-threads <数量> 单个关卡内部的 BFS / A* 搜索线程数，默认1，0 表示全部核心\n");
+    printf("  --external <目录> BFS 各层以有序段文件存于该目录，内存放不下的穷举用\n");
+    printf("  --ram-mb <MB>    --external 时的内存预算（每个关卡），默认 256\n");
+    printf("  --mem-mb <MB>    每个关卡的内存预算，默认不限\n");
+    printf("  --mem-action abort|ida|compact  超出内存预算时放弃 / 改用 IDA* / 压缩各表后继续，默认 abort\n");
+    printf("  --presolve-states <数量>  求解前的无解判定至多穷举的状态数，0 表示不做判定，默认 256\n");
+    printf("  --tt-mb <MB>     IDA* 置换表内存预算（每个线程），默认 64\n");
+    printf("  --tt-policy deeper|always  IDA* 置换表满时的替换策略，默认 deeper\n");
+}
+
+// 规范化算法名称，支持小写与 astar 写法
+static string normalizeAlgorithm(string name) {
+    transform(name.begin(), name.end(), name.begin(), ::toupper);
+    if (name == "ASTAR") return "A*";
+    if (name == "IDASTAR" || name == "IDA") return "IDA*";
+    if (name == "ARASTAR" || name == "ARA") return "ARA*";
+    if (name == "PORTFOLIO") return "Portfolio";
+    if (name == "BEAM") return "Beam";
+    return name;
+}
+
+// 解析剪枝规则列表："all"、"none" 或 "0,2,3"
+static bool parsePruneRules(const string& text, unsigned& rules) {
+    if (text == "all") { rules = PRUNE_ALL; return true; }
+    if (text == "none") { rules = PRUNE_NONE; return true; }
+
+    rules = PRUNE_NONE;
+    istringstream in(text);
+    string item;
+    while (getline(in, item, ',')) {
+        int rule = atoi(item.c_str());
+        if (item.empty() || rule < 0 || rule >= PRUNE_RULE_COUNT) return false;
+        rules |= 1u << rule;
+    }
+    return true;
+}
+
+static bool parseArguments(int argc, char** argv, BatchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if ((arg == "-i" || arg == "--input") && hasValue) options.inputPath = argv[++i];
+        else if ((arg == "-o" || arg == "--output") && hasValue) options.solutionPath = argv[++i];
+        else if ((arg == "-s" || arg == "--stats") && hasValue) options.statsPath = argv[++i];
+        else if (arg == "--corpus-out" && hasValue) options.corpusPath = argv[++i];
+        else if ((arg == "-a" || arg == "--algorithm") && hasValue) options.algorithm = normalizeAlgorithm(argv[++i]);
+        else if ((arg == "-j" || arg == "--threads") && hasValue) options.threads = atoi(argv[++i]);
+        else if (arg == "--expected-states" && hasValue) options.expectedStates = (size_t)atoll(argv[++i]);
+        else if (arg == "--no-canonical") options.canonicalizeTubes = false;
+        else if (arg == "--layered") options.layeredBFS = true;
+        else if (arg == "--search-threads" && hasValue) options.searchThreads = atoi(argv[++i]);
+        else if (arg == "--color-symmetry") options.canonicalizeColors = true;
+        else if (arg == "--heuristic" && hasValue) {
+            options.heuristic = atoi(argv[++i]);
+            if (options.heuristic < 0 || options.heuristic >= HEURISTIC_COUNT) {
+                fprintf(stderr, "无效的启发函数: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (arg == "--compare-heuristics") options.compareHeuristics = true;
+        else if (arg == "--weight" && hasValue) {
+            options.heuristicWeight = atof(argv[++i]);
+            if (options.heuristicWeight < 1.0) {
+                fprintf(stderr, "无效的启发权重: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (arg == "--anytime-weight" && hasValue) options.anytimeWeight = atof(argv[++i]);
+        else if (arg == "--anytime-step" && hasValue) options.anytimeWeightStep = atof(argv[++i]);
+        else if (arg == "--time-limit" && hasValue) options.timeLimitMs = atoll(argv[++i]);
+        else if (arg == "--beam-width" && hasValue) {
+            options.beamWidth = atoi(argv[++i]);
+            if (options.beamWidth < 1) {
+                fprintf(stderr, "无效的束宽度: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else if (arg == "--beam-restarts" && hasValue) options.beamRestarts = max(0, atoi(argv[++i]));
+        else if (arg == "--quality" && hasValue) {
+            string quality = argv[++i];
+            if (quality == "optimal") options.portfolioQuality = QUALITY_OPTIMAL;
+            else if (quality == "any") options.portfolioQuality = QUALITY_ANY;
+            else {
+                fprintf(stderr, "无效的质量要求: %s\n", quality.c_str());
+                return false;
+            }
+        }
+        else if (arg == "--external" && hasValue) {
+            options.externalBFS = true;
+            options.scratchDirectory = argv[++i];
+        }
+        else if (arg == "--ram-mb" && hasValue) options.externalMemoryBytes = (size_t)atoll(argv[++i]) << 20;
+        else if (arg == "--presolve-states" && hasValue) options.presolveStates = (size_t)atoll(argv[++i]);
+        else if (arg == "--mem-mb" && hasValue) options.memoryBudgetBytes = atoll(argv[++i]) << 20;
+        else if (arg == "--mem-action" && hasValue) {
+            string action = argv[++i];
+            if (action == "abort") options.memoryAction = MEMORY_ABORT;
+            else if (action == "ida") options.memoryAction = MEMORY_FALLBACK;
+            else if (action == "compact") options.memoryAction = MEMORY_COMPACT;
+            else {
+                fprintf(stderr, "无效的内存预算处理方式: %s\n", action.c_str());
+                return false;
+            }
+        }
+        else if (arg == "--tt-mb" && hasValue) options.transpositionBytes = (size_t)atoll(argv[++i]) << 20;
+        else if (arg == "--tt-policy" && hasValue) {
+            string policy = argv[++i];
+            if (policy == "deeper") options.transpositionPolicy = REPLACE_DEEPER;
+            else if (policy == "always") options.transpositionPolicy = REPLACE_ALWAYS;
+            else {
+                fprintf(stderr, "无效的替换策略: %s\n", policy.c_str());
+                return false;
+            }
+        }
+        else if (arg == "--prune" && hasValue) {
+            if (!parsePruneRules(argv[++i], options.pruneRules)) {
+                fprintf(stderr, "无效的剪枝规则: %s\n", argv[i]);
+                return false;
+            }
+        }
+        else {
+            fprintf(stderr, "未知参数: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return !options.inputPath.empty();
+}
+
+// 解析一行关卡描述，失败时返回错误信息
+static string parsePuzzleLine(const string& line, GameState& state) {
+    istringstream in(line);
+    int capacity = 0;
+    if (!(in >> capacity) || capacity <= 0) return "容量无效";
+
+    string token;
+    while (in >> token) {
+        Tube tube(capacity);
+        if (token != "-") {
+            istringstream cells(token);
+            string cell;
+            while (getline(cells, cell, ',')) {
+                int color = atoi(cell.c_str());
+                if (color <= 0) return "颜色无效: " + cell;
+                tube.colors.push_back(color);
+            }
+        }
+        if (tube.isOverCapacity()) return "试管超容: " + token;
+        state.tubes.push_back(tube);
+    }
+    if (state.tubes.empty()) return "没有试管";
+
+    state.operation = "初始状态";
+    return "";
+}
+
+static void initJob(BatchJob& job, int id) {
+    job.id = id;
+    job.done = false;
+    job.solved = false;
+    job.threadsUsed = 1;
+    job.speedup = 1.0;
+    job.portfolioWinner = -1;
+    job.bound = 0.0;
+    job.diskBytes = 0;
+    job.stats = AlgorithmStats();
+    for (int h = 0; h < HEURISTIC_COUNT; h++) {
+        job.heuristicStats[h] = job.stats;
+        job.heuristicTableStats[h] = StateTableStats();
+    }
+}
+
+// 从语料库读入关卡（只用关卡，忽略其中已有的解）
+static bool loadCorpusJobs(const string& path, vector<BatchJob>& jobs) {
+    CorpusReader corpus;
+    if (!corpus.open(path)) {
+        fprintf(stderr, "语料库 %s: %s\n", path.c_str(), corpus.error().c_str());
+        return false;
+    }
+    jobs.resize(corpus.size());
+    for (size_t i = 0; i < corpus.size(); i++) {
+        BatchJob& job = jobs[i];
+        initJob(job, (int)i + 1);
+        PackedState level;
+        if (corpus.level(i, level)) job.start = unpackState(level);
+        else job.parseError = "语料库记录损坏";
+    }
+    return true;
+}
+
+static bool loadJobs(const string& path, vector<BatchJob>& jobs) {
+    if (IsCorpusFile(path)) return loadCorpusJobs(path, jobs);
+
+    ifstream in(path.c_str());
+    if (!in) return false;
+
+    string line;
+    int id = 0;
+    while (getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+
+        BatchJob job;
+        initJob(job, ++id);
+        job.parseError = parsePuzzleLine(line, job.start);
+        jobs.push_back(job);
+    }
+    return true;
+}
+
+// 语料库要求各关卡试管数、容量相同：按第一个可编码的关卡打开，颜色数取该关卡的最大颜色号
+static bool openCorpus(CorpusWriter& corpus, const string& path, const vector<BatchJob>& jobs) {
+    for (size_t i = 0; i < jobs.size(); i++) {
+        PackedState level;
+        if (!jobs[i].parseError.empty() || !packState(jobs[i].start, level)) continue;
+        int colors = 1;
+        for (int t = 0; t < level.numTubes; t++) {
+            for (int j = 0; j < level.tubeSize(t); j++) colors = max(colors, level.colorAt(t, j));
+        }
+        return corpus.open(path, level.numTubes, colors, level.capacity, true);
+    }
+    return corpus.open(path, 1, 1, 1, true);
+}
+
+// 把关卡与解追加到语料库，与文件头不符的关卡跳过并返回 false
+static bool writeCorpusJob(CorpusWriter& corpus, const BatchJob& job) {
+    PackedState level;
+    if (!job.parseError.empty() || !packState(job.start, level)) return false;
+    return job.solved ? corpus.append(level, job.corpusMoves) : corpus.append(level);
+}
+
+static void solveJob(BatchJob& job, const BatchOptions& options) {
+    if (!job.parseError.empty()) {
+        job.reason = job.parseError;
+        return;
+    }
+
+    SolverContext ctx;
+    ctx.initialEmptyTubes = countEmptyTubes(job.start);
+    ctx.expectedStates = options.expectedStates;
+    ctx.canonicalizeTubes = options.canonicalizeTubes;
+    ctx.canonicalizeColors = options.canonicalizeColors;
+    ctx.pruneRules = options.pruneRules;
+    ctx.transpositionBytes = options.transpositionBytes;
+    ctx.transpositionPolicy = options.transpositionPolicy;
+    ctx.layeredBFS = options.layeredBFS;
+    ctx.externalBFS = options.externalBFS;
+    ctx.scratchDirectory = options.scratchDirectory;
+    ctx.externalMemoryBytes = options.externalMemoryBytes;
+    ctx.memoryBudgetBytes = options.memoryBudgetBytes;
+    ctx.memoryAction = options.memoryAction;
+    ctx.presolveStates = options.presolveStates;
+    ctx.searchThreads = options.searchThreads;
+    ctx.heuristicWeight = options.heuristicWeight;
+    ctx.portfolioQuality = options.portfolioQuality;
+    ctx.anytimeWeight = options.anytimeWeight;
+    ctx.anytimeWeightStep = options.anytimeWeightStep;
+    ctx.timeLimitMs = options.timeLimitMs;
+    ctx.beamWidth = options.beamWidth;
+    ctx.beamRestarts = options.beamRestarts;
+
+    // 对比模式：先用其他启发函数各求解一次，只记录统计；最后用选定的启发函数求解并输出解法。
+    // 各启发函数都经由 SolveWithAlgorithm 求解，与选定的那一行走同一个入口
+    if (options.compareHeuristics) {
+        for (int h = 0; h < HEURISTIC_COUNT; h++) {
+            if (h == options.heuristic) continue;
+            ctx.heuristic = h;
+            SolveWithAlgorithm("A*", job.start, ctx);
+            job.heuristicStats[h] = ctx.stats;
+            job.heuristicTableStats[h] = ctx.tableStats;
+        }
+    }
+
+    ctx.heuristic = options.heuristic;
+    job.solved = SolveWithAlgorithm(options.algorithm, job.start, ctx);
+    job.heuristicStats[options.heuristic] = ctx.stats;
+    job.heuristicTableStats[options.heuristic] = ctx.tableStats;
+    job.stats = ctx.stats;
+    job.tableStats = ctx.tableStats;
+    job.reason = ctx.noSolutionReason;
+    job.threadsUsed = ctx.threadsUsed;
+    job.speedup = ctx.parallelSpeedup;
+    job.portfolioStats = ctx.portfolioStats;
+    job.portfolioWinner = ctx.portfolioWinner;
+    job.bound = ctx.suboptimalityBound;
+    job.diskBytes = ctx.externalDiskBytes;
+
+    for (size_t i = 1; i < ctx.solutionPath.size(); i++) {
+        const GameState& step = ctx.solutionPath[i];
+        job.moves.push_back(to_string(step.moveFrom + 1) + ">" + to_string(step.moveTo + 1));
+        CorpusMove move = { (uint8_t)step.moveFrom, (uint8_t)step.moveTo };
+        job.corpusMoves.push_back(move);
+    }
+}
+
+static void writeStatsRow(FILE* statsFile, const BatchJob& job, const char* status, const char* heuristic,
+    const AlgorithmStats& stats, const StateTableStats& tableStats) {
+    static const char* memoryActions[] = { "none", "abort", "fallback", "compact" };
+    char bound[32] = "-";
+    if (job.bound > 0) sprintf(bound, "%.3f", job.bound);
+    fprintf(statsFile, "%d,%s,%s,%s,%d,%d,%d,%lld,%lld,%zu,%.3f,%.3f,%lld,%lld,%lld,%lld,%lld,%d,%.2f,%s,%lld,%lld,%s\n", job.id, stats.algorithmName.c_str(),
+        heuristic, status, stats.solutionLength, stats.statesExplored, stats.maxMemory, stats.solvingTime,
+        stats.peakMemoryBytes / 1024,
+        tableStats.size, tableStats.loadFactor, tableStats.averageProbes,
+        stats.prunedByRule[PRUNE_UNIFORM_TO_EMPTY], stats.prunedByRule[PRUNE_EXTRA_EMPTY],
+        stats.prunedByRule[PRUNE_UNDO], stats.prunedByRule[PRUNE_COMPLETED],
+        stats.prunedByRule[PRUNE_DEAD_STATE], job.threadsUsed, job.speedup, bound,
+        job.diskBytes / 1024, stats.memoryBudgetBytes / 1024,
+        memoryActions[stats.memoryAction >= 0 && stats.memoryAction < MEMORY_ACTION_COUNT ? stats.memoryAction : 0]);
+}
+
+static void writeJob(FILE* solutionFile, FILE* statsFile, const BatchJob& job, const BatchOptions& options) {
+    const char* status = !job.parseError.empty() ? "error" : (job.solved ? "solved" : "unsolved");
+    if (!job.solved && job.stats.memoryAction == MEMORY_ABORT) status = "out_of_memory";  // 未搜索完，不能算作无解
+
+    fprintf(solutionFile, "%d\t%s\t%d\t", job.id, status, job.solved ? (int)job.moves.size() : -1);
+    if (job.solved) {
+        for (size_t i = 0; i < job.moves.size(); i++) {
+            fprintf(solutionFile, i == 0 ? "%s" : " %s", job.moves[i].c_str());
+        }
+    }
+    else {
+        fprintf(solutionFile, "%s", job.reason.c_str());
+    }
+    fprintf(solutionFile, "\n");
+
+    if (statsFile == NULL) return;
+    if (options.compareHeuristics && job.parseError.empty()) {
+        for (int h = 0; h < HEURISTIC_COUNT; h++) {
+            writeStatsRow(statsFile, job, status, GetHeuristicName(h), job.heuristicStats[h], job.heuristicTableStats[h]);
+        }
+    }
+    else {
+        bool informed = options.algorithm == "A*" || options.algorithm == "IDA*" || options.algorithm == "ARA*";
+        const char* heuristic = informed ? GetHeuristicName(options.heuristic) : "-";
+        writeStatsRow(statsFile, job, status, heuristic, job.stats, job.tableStats);
+    }
+    for (size_t i = 0; i < job.portfolioStats.size(); i++) {
+        const AlgorithmStats& stats = job.portfolioStats[i];
+        const char* memberStatus = stats.hasSolution ? "solved" : (stats.solutionStatus == "已取消" ? "cancelled" :
+            (stats.memoryAction == MEMORY_ABORT ? "out_of_memory" : "unsolved"));
+        writeStatsRow(statsFile, job, memberStatus, "-", stats, StateTableStats());
+    }
+}
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    if (options.algorithm != "BFS" && options.algorithm != "DFS" && options.algorithm != "A*" &&
+        options.algorithm != "IDA*" && options.algorithm != "ARA*" && options.algorithm != "Beam" &&
+        options.algorithm != "Portfolio") {
+        fprintf(stderr, "不支持的算法: %s\n", options.algorithm.c_str());
+        return 1;
+    }
+    if (options.compareHeuristics && options.algorithm != "A*") {
+        fprintf(stderr, "--compare-heuristics 只用于 A*，已改用 A*\n");
+        options.algorithm = "A*";
+    }
+
+    vector<BatchJob> jobs;
+    if (!loadJobs(options.inputPath, jobs)) {
+        fprintf(stderr, "无法读取关卡文件: %s\n", options.inputPath.c_str());
+        return 1;
+    }
+
+    FILE* solutionFile = stdout;
+    if (!options.solutionPath.empty()) {
+        solutionFile = fopen(options.solutionPath.c_str(), "w");
+        if (solutionFile == NULL) {
+            fprintf(stderr, "无法写入解法文件: %s\n", options.solutionPath.c_str());
+            return 1;
+        }
+    }
+    FILE* statsFile = NULL;
+    if (!options.statsPath.empty()) {
+        statsFile = fopen(options.statsPath.c_str(), "w");
+        if (statsFile == NULL) {
+            fprintf(stderr, "无法写入统计文件: %s\n", options.statsPath.c_str());
+            return 1;
+        }
+        fprintf(statsFile, "id,algorithm,heuristic,status,steps,states_explored,max_memory,time_ms,peak_kb,visited,load_factor,avg_probes,pruned_uniform,pruned_empty,pruned_undo,pruned_completed,pruned_dead,threads,speedup,bound,disk_kb,mem_budget_kb,mem_action\n");
+    }
+
+    CorpusWriter corpus;
+    if (!options.corpusPath.empty() && !openCorpus(corpus, options.corpusPath, jobs)) {
+        fprintf(stderr, "无法写入语料库: %s\n", options.corpusPath.c_str());
+        return 1;
+    }
+    int corpusSkipped = 0;
+
+    int threadCount = options.threads > 0 ? options.threads : (int)thread::hardware_concurrency();
+    if (threadCount <= 0) threadCount = 1;
+    threadCount = min(threadCount, max(1, (int)jobs.size()));
+
+    fprintf(stderr, "关卡数: %d, 算法: %s, 线程数: %d\n",
+        (int)jobs.size(), options.algorithm.c_str(), threadCount);
+
+    auto startTime = high_resolution_clock::now();
+
+    // 工作线程按序领取任务；完成后按关卡顺序写出，保证输出顺序稳定且中途中断也不丢失已写结果
+    atomic<int> nextJob(0);
+    mutex outputMutex;
+    int nextToWrite = 0;
+    int solvedCount = 0;
+    long long heuristicExplored[HEURISTIC_COUNT] = { 0 };
+    long long heuristicTime[HEURISTIC_COUNT] = { 0 };
+    vector<int> portfolioWins;
+
+    auto worker = [&]() {
+        while (true) {
+            int index = nextJob.fetch_add(1);
+            if (index >= (int)jobs.size()) break;
+
+            solveJob(jobs[index], options);
+
+            lock_guard<mutex> lock(outputMutex);
+            jobs[index].done = true;
+            while (nextToWrite < (int)jobs.size() && jobs[nextToWrite].done) {
+                BatchJob& job = jobs[nextToWrite];
+                writeJob(solutionFile, statsFile, job, options);
+                if (corpus.isOpen() && !writeCorpusJob(corpus, job)) corpusSkipped++;
+                if (job.solved) solvedCount++;
+                for (int h = 0; h < HEURISTIC_COUNT; h++) {
+                    heuristicExplored[h] += job.heuristicStats[h].statesExplored;
+                    heuristicTime[h] += job.heuristicStats[h].solvingTime;
+                }
+                if (job.portfolioWinner >= 0) {
+                    if ((int)portfolioWins.size() < (int)job.portfolioStats.size()) portfolioWins.resize(job.portfolioStats.size());
+                    portfolioWins[job.portfolioWinner]++;
+                }
+
+                // 写出后释放结果，避免长时间批处理占用内存
+                job.moves.clear();
+                job.moves.shrink_to_fit();
+                job.corpusMoves.clear();
+                job.corpusMoves.shrink_to_fit();
+                job.start.tubes.clear();
+                nextToWrite++;
+            }
+            fflush(solutionFile);
+            if (statsFile != NULL) fflush(statsFile);
+        }
+    };
+
+    vector<thread> workers;
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(thread(worker));
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+
+    auto endTime = high_resolution_clock::now();
+    long long totalTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    fprintf(stderr, "完成: %d/%d 有解, 总耗时 %lld ms\n", solvedCount, (int)jobs.size(), totalTime);
+    if (options.compareHeuristics) {
+        for (int h = 0; h < HEURISTIC_COUNT; h++) {
+            fprintf(stderr, "  启发函数 %d (%s): 扩展状态 %lld, 求解时间 %lld ms\n",
+                h, GetHeuristicName(h), heuristicExplored[h], heuristicTime[h]);
+        }
+    }
+
+    if (!portfolioWins.empty()) {
+        vector<PortfolioMember> members = DefaultPortfolio();
+        for (size_t i = 0; i < portfolioWins.size() && i < members.size(); i++) {
+            fprintf(stderr, "  %s: 胜出 %d 次\n", GetPortfolioMemberName(members[i]).c_str(), portfolioWins[i]);
+        }
+    }
+
+    if (corpus.isOpen()) {
+        size_t written = corpus.count();
+        if (!corpus.close()) {
+            fprintf(stderr, "写入语料库失败: %s\n", options.corpusPath.c_str());
+            return 1;
+        }
+        fprintf(stderr, "语料库: 写入 %d 个关卡", (int)written);
+        if (corpusSkipped > 0) fprintf(stderr, ", 跳过 %d 个（解析失败或试管数、容量、颜色与第一个关卡不符）", corpusSkipped);
+        fprintf(stderr, "\n");
+    }
+
+    if (solutionFile != stdout) fclose(solutionFile);
+    if (statsFile != NULL) fclose(statsFile);
+    return 0;
+}
@@ -17,6 +17,11 @@
 #include <chrono>
 #include <set>
 #include <iomanip>
+#include <thread>
+#include <mutex>
+#include "SolverCore.h"
+#include "LevelGenerator.h"
+#include "LevelCorpus.h"
 
 using namespace std;
 using namespace chrono;
@@ -45,185 +50,6 @@ COLORREF GetColorByIndex(int index) {
     return colors[index];
 }
 
-const char* GetColorName(int index) {
-    static const char* names[] = {
-        "空", "红", "绿", "蓝", "黄",
-        "紫", "青", "橙", "灰", "粉",
-        "薄荷", "淡紫"
-    };
-    if (index < 0 || index >= 12) return "未知";
-    return names[index];
-}
-
-// ==================== 数据结构定义 ====================
-struct Tube {
-    vector<int> colors;  // 从底部到顶部的水颜色 (0=空)
-    int capacity;        // 试管容量
-
-    Tube(int cap = 4) : capacity(cap) {}
-
-    bool isEmpty() const { return colors.empty(); }
-    bool isFull() const { return (int)colors.size() >= capacity; }
-    int size() const { return (int)colors.size(); }
-    int freeSpace() const { return capacity - (int)colors.size(); }
-
-    // 获取顶部颜色，空试管返回-1
-    int topColor() const {
-        if (colors.empty()) return -1;
-        return colors.back();
-    }
-
-    // 获取顶部连续同色水的数量
-    int topSegmentSize() const {
-        if (colors.empty()) return 0;
-        int topColor = colors.back();
-        int count = 0;
-        for (auto it = colors.rbegin(); it != colors.rend(); ++it) {
-            if (*it == topColor) count++;
-            else break;
-        }
-        return count;
-    }
-
-    // 是否可以倒入颜色为color的水
-    bool canPourInto(int color) const {
-        if (isFull()) return false;
-        return isEmpty() || topColor() == color;
-    }
-
-    // 倒入指定颜色的水
-    void pourIn(int color, int amount) {
-        for (int i = 0; i < amount && !isFull(); i++) {
-            colors.push_back(color);
-        }
-    }
-
-    // 倒出指定数量的水
-    void pourOut(int amount) {
-        if (amount >= (int)colors.size()) {
-            colors.clear();
-        }
-        else {
-            colors.resize(colors.size() - amount);
-        }
-    }
-
-    // 检查试管是否已完成（只有一种颜色或为空）
-    bool isComplete() const {
-        if (colors.empty()) return true;
-        int firstColor = colors[0];
-        for (int color : colors) {
-            if (color != firstColor) return false;
-        }
-        return true;
-    }
-
-    // 检查是否超容（用于可视化）
-    bool isOverCapacity() const {
-        return (int)colors.size() > capacity;
-    }
-};
-
-// 游戏状态
-struct GameState {
-    vector<Tube> tubes;
-    string operation;
-    GameState* parent;
-    int gCost;  // 从起始状态到当前状态的代价
-    int hCost;  // 启发式代价估计
-    int moveFrom;  // 从哪个试管移动
-    int moveTo;    // 移动到哪个试管
-    int moveAmount; // 移动数量
-    bool isInvalid; // 是否为无效状态（用于可视化）
-
-    GameState() : parent(NULL), gCost(0), hCost(0), moveFrom(-1), moveTo(-1), moveAmount(0), isInvalid(false) {}
-
-    GameState(const GameState& other) {
-        tubes = other.tubes;
-        operation = other.operation;
-        parent = other.parent;
-        gCost = other.gCost;
-        hCost = other.hCost;
-        moveFrom = other.moveFrom;
-        moveTo = other.moveTo;
-        moveAmount = other.moveAmount;
-        isInvalid = other.isInvalid;
-    }
-
-    // 生成状态唯一键
-    string getKey() const {
-        string key;
-        for (const auto& tube : tubes) {
-            key += "[";
-            for (int color : tube.colors) {
-                key += to_string(color) + ",";
-            }
-            key += "];";
-        }
-        return key;
-    }
-
-    // 计算启发式代价 - 改进为可采纳启发函数
-    int calculateHeuristic() const {
-        int cost = 0;
-
-        // 计算每个试管中颜色变化的次数
-        for (const auto& tube : tubes) {
-            if (tube.isEmpty()) continue;
-
-            // 统计颜色变化的次数
-            int colorChanges = 0;
-            for (size_t i = 1; i < tube.colors.size(); i++) {
-                if (tube.colors[i] != tube.colors[i - 1]) {
-                    colorChanges++;
-                }
-            }
-
-            // 每个颜色变化至少需要一次移动来修正
-            cost += colorChanges;
-        }
-
-        // 保守估计，确保不会高估实际代价
-        return cost / 2;
-    }
-
-    // 深度复制
-    GameState deepCopy() const {
-        GameState newState;
-        newState.tubes = this->tubes;
-        newState.operation = this->operation;
-        newState.parent = this->parent;
-        newState.gCost = this->gCost;
-        newState.hCost = this->hCost;
-        newState.moveFrom = this->moveFrom;
-        newState.moveTo = this->moveTo;
-        newState.moveAmount = this->moveAmount;
-        newState.isInvalid = this->isInvalid;
-        return newState;
-    }
-
-    // 获取移动描述
-    string getMoveDescription() const {
-        if (moveFrom == -1 || moveTo == -1) return "初始状态";
-
-        char buffer[100];
-        int fromTube = moveFrom + 1;
-        int toTube = moveTo + 1;
-        int color = tubes[moveFrom].topColor();
-        sprintf(buffer, "从试管%d倒入试管%d (颜色: %s, 数量: %d)",
-            fromTube, toTube, GetColorName(color), moveAmount);
-        return string(buffer);
-    }
-
-    // 检查是否为无效状态（超容）
-    bool hasOverCapacityTube() const {
-        for (const auto& tube : tubes) {
-            if (tube.isOverCapacity()) return true;
-        }
-        return false;
-    }
-};
-
 // ==================== 参数输入框结构体 ====================
 struct ParamInputBox {
     int x, y, width, height;
@@ -345,26 +171,47 @@ string noSolutionReason = "";       // 无解原因
 char statusMessage[100] = "就绪 - 点击试管选择源/目标";
 int totalStatesExplored = 0;
 int maxStatesInMemory = 0;
+long long peakMemoryBytes = 0;      // 峰值内存（字节）
 int initialEmptyTubes = 0;          // 初始空瓶数
 long long solvingTime = 0;          // 求解时间（毫秒）
 string currentAlgorithm = "BFS";    // 当前算法
+int currentHeuristic = HEURISTIC_BLOCKS;  // A*启发函数（H键切换）
+bool layeredBFS = false;            // BFS按层排序批量去重（L键切换）
+bool parallelSearch = false;        // BFS/A* 使用全部核心并行搜索（P键切换）
+int portfolioQuality = QUALITY_OPTIMAL;  // 组合求解接受的解（Q键切换）
+long long anytimeTimeLimitMs = 5000;    // ARA* 在界面中的时间上限（毫秒）
+double anytimeBound = 0.0;              // ARA* 最近发布的解的次优界，0 表示尚未求解
+int beamWidth = 1000;                   // 束搜索每层保留的状态数
+const size_t GENERATE_PRESOLVE_STATES = 4096;   // 生成场景时无解判定至多穷举的状态数
+bool solvableGeneration = false;        // 生成场景时随机打乱后求解验证，保证有解（G键切换）
+unsigned long long generatedLevelCount = 0;     // 保证有解的生成用过的关卡序号
+const char* CORPUS_FILE = "levels.wsc";         // S键保存、O键读取的关卡语料库
+size_t corpusCursor = 0;                        // O键下一次读取的关卡下标
+long long memoryBudgetMB = 1024;        // 每次求解的内存预算（MB）
+int memoryAction = MEMORY_ABORT;        // 超出预算时的处理（M键切换）
+int lastMemoryAction = MEMORY_NONE;     // 最近一次求解实际采取的处理
+
+// 后台求解（见 startBackgroundSolve）
+const DWORD PROGRESS_REDRAW_MS = 100;   // 求解期间刷新进度的间隔
+thread solverThread;
+unique_ptr<SolverContext> activeSolve;  // 正在进行的求解，结束后由界面线程读取结果
+bool solveSucceeded = false;            // 求解线程的返回值，结束后才读取
+atomic<bool> solverFinished(false);
+atomic<bool> cancelSolve(false);        // 空格/X键或求解按钮置位
+ProgressChannel solveProgress;
+unsigned progressSeen = 0;
+ProgressSnapshot lastProgress;          // 最近取到的进度快照
+mutex anytimeLock;                      // 保护 ARA* 交给界面线程的中间解
+vector<GameState> anytimePath;
+double anytimePathBound = 0.0;
+bool anytimePathPending = false;
 
 // 游戏交互相关
 int selectedTube = -1;              // 当前选中的试管索引
 vector<int> highlightedTubes;       // 可操作的高亮试管
 
 // 算法性能统计
-struct AlgorithmStats {
-    int statesExplored;
-    int maxMemory;
-    long long solvingTime;
-    int solutionLength;
-    string algorithmName;
-    bool hasSolution;
-    string solutionStatus;
-};
-
-AlgorithmStats bfsStats, dfsStats, astarStats;
+AlgorithmStats bfsStats, dfsStats, astarStats, idaStats, araStats, beamStats;
 
 // 参数配置
 int currentN = 6;  // 水壶数
@@ -378,15 +225,21 @@ int activeInputBoxIndex = -1;  // 当前激活的输入框索引
 
 // ==================== 辅助函数声明 ====================
 GameState GenerateCustomLevel(int n, int k, int m);
-vector<GameState> generateNextStates(const GameState& current, vector<GameState>& invalidStates);
-bool isGoalState(const GameState& state);
-bool BFS_Solve(const GameState& start);
-bool DFS_Solve(const GameState& start);
-bool AStar_Solve(const GameState& start);
+void saveLevelToCorpus();
+void loadLevelFromCorpus();
+void startBackgroundSolve();
+void cancelBackgroundSolve();
+bool pollBackgroundSolve();
+void finishBackgroundSolve();
+void printPruneStats();
+void appendMemoryNote();
+AlgorithmStats& statsForAlgorithm(const string& algorithm);
+void fillPortfolioStats(const SolverContext& ctx);
 void drawTube(int index, const Tube& tube, int x, int y, bool isSelected = false,
     bool isHighlighted = false, bool isInvalid = false, bool isGoal = false);
 void drawInfoPanel();
 void drawAlgorithmPanel();
+void drawAlgorithmStatsRow(int panelX, int y, const char* name, const AlgorithmStats& stats);
 void drawParameterPanel();
 void drawNoSolutionWarning();
 void drawCurrentState(const GameState& state);
@@ -395,8 +248,6 @@ bool isPointInButton(int x, int y, int btnX, int btnY, int width, int height);
 void handleTubeClick(int tubeIndex);
 void resetGame();
 void clearSolution();
-vector<string> extractMoveSequence(const vector<GameState>& path);
-void printSolutionToConsole(const vector<GameState>& path, const string& algorithm);
 void drawButton(int x, int y, int width, int height, const char* text, bool isSelected = false,
     COLORREF bgColor = RGB(70, 130, 180), COLORREF textColor = RGB(240, 240, 240),
     int fontSize = 18);
@@ -542,6 +393,26 @@ GameState GenerateCustomLevel(int n, int k, int m) {
     noSolutionReason = "";
     showNoSolutionWarning = false;
 
+    // 保证有解的生成：随机打乱后用 A* 验证，难度与随机打乱相同（反向倒水生成的关卡明显偏简单）；
+    // 参数超出生成器范围或多次尝试未成功时退回不验证的随机打乱
+    if (solvableGeneration) {
+        GeneratorOptions options;
+        options.numTubes = n;
+        options.numColors = k;
+        options.capacity = m;
+        options.seed = (unsigned long long)time(NULL);
+        options.shuffle = true;
+        if (CheckGeneratorOptions(options).empty()) {
+            GeneratedLevel generated = GenerateSolvableLevel(options, generatedLevelCount++);
+            if (generated.ok) {
+                initialEmptyTubes = n - k;
+                state = generated.level;
+                state.operation = "初始状态 (保证有解)";
+                return state;
+            }
+        }
+    }
+
     // 创建颜色池
     vector<int> colorPool;
     for (int i = 1; i <= k; i++) {
@@ -590,509 +461,362 @@ GameState GenerateCustomLevel(int n, int k, int m) {
     state.moveAmount = 0;
     state.isInvalid = false;
 
+    // 快速无解判定：紧约束场景常见的死局不必等完整搜索
+    string reason;
+    if (ProveUnsolvable(state, initialEmptyTubes, GENERATE_PRESOLVE_STATES, reason)) {
+        noSolution = true;
+        noSolutionReason = reason;
+        showNoSolutionWarning = true;
+        state.operation += " (无解)";
+    }
+
     return state;
 }
 
-// 生成下一状态，同时记录无效转移
-vector<GameState> generateNextStates(const GameState& current, vector<GameState>& invalidStates) {
-    vector<GameState> nextStates;
-    int n = (int)current.tubes.size();
-
-    for (int from = 0; from < n; from++) {
-        if (current.tubes[from].isEmpty()) continue;
-
-        int topColor = current.tubes[from].topColor();
-        int segmentSize = current.tubes[from].topSegmentSize();
-
-        for (int to = 0; to < n; to++) {
-            if (from == to) continue;
-
-            // 检查转移是否有效
-            bool isValid = true;
-            string invalidReason = "";
-
-            // 检查目标试管是否能接收
-            if (current.tubes[to].isFull()) {
-                isValid = false;
-                invalidReason = "超容";
-            }
-            else if (!current.tubes[to].isEmpty() && current.tubes[to].topColor() != topColor) {
-                isValid = false;
-                invalidReason = "不同色";
-            }
-
-            if (isValid) {
-                int maxPour = min(segmentSize, current.tubes[to].freeSpace());
-                if (maxPour == 0) continue;
-
-                GameState next = current.deepCopy();
-                next.tubes[from].pourOut(maxPour);
-                next.tubes[to].pourIn(topColor, maxPour);
-
-                // 记录移动信息
-                next.moveFrom = from;
-                next.moveTo = to;
-                next.moveAmount = maxPour;
-
-                char op[100];
-                sprintf(op, "%d→%d (颜色%d, %d单位)", from + 1, to + 1, topColor, maxPour);
-                next.operation = op;
-                next.parent = new GameState(current);
-                next.gCost = current.gCost + 1;
-                next.hCost = next.calculateHeuristic();
-                next.isInvalid = false;
-                nextStates.push_back(next);
+// ==================== 关卡存取 ====================
+// S键把当前关卡（已求解时连同解）追加到语料库，O键依次读回；格式见 LevelCorpus.h
+
+void saveLevelToCorpus() {
+    PackedState level;
+    if (solutionPath.empty() || !packState(solutionPath[0], level)) {
+        strcpy(statusMessage, "当前关卡超出语料库格式范围");
+        return;
+    }
+    int colors = 1;
+    for (int t = 0; t < level.numTubes; t++) {
+        for (int j = 0; j < level.tubeSize(t); j++) colors = max(colors, level.colorAt(t, j));
+    }
+
+    // 语料库只能顺序写入：已有关卡连同新关卡写到临时文件，再替换原文件
+    string tempPath = string(CORPUS_FILE) + ".tmp";
+    CorpusWriter writer;
+    {
+        CorpusReader existing;
+        bool keep = existing.open(CORPUS_FILE);
+        // 文件存在却打不开（写入中断、版本不同或根本不是语料库）时不覆盖，免得丢掉原有关卡
+        FILE* present = keep ? NULL : fopen(CORPUS_FILE, "rb");
+        if (present != NULL) {
+            fclose(present);
+            snprintf(statusMessage, sizeof(statusMessage), "%s: %s，未保存", CORPUS_FILE, existing.error().c_str());
+            return;
+        }
+        if (keep && (existing.numTubes() != level.numTubes || existing.capacity() != level.capacity)) {
+            sprintf(statusMessage, "%s 中关卡规格不同，未保存", CORPUS_FILE);
+            return;
+        }
+        if (keep) colors = max(colors, existing.numColors());
+        if (!writer.open(tempPath, level.numTubes, colors, level.capacity, true)) {
+            sprintf(statusMessage, "无法写入 %s", tempPath.c_str());
+            return;
+        }
+        for (size_t i = 0; keep && i < existing.size(); i++) {
+            PackedState old;
+            if (!existing.level(i, old)) continue;
+            const uint8_t* moves;
+            int count = existing.solution(i, moves);
+            if (count < 0) {
+                writer.append(old);
+                continue;
             }
-            else {
-                // 记录无效转移状态（用于可视化）
-                GameState invalid = current.deepCopy();
-                invalid.moveFrom = from;
-                invalid.moveTo = to;
-                invalid.moveAmount = 0;
-                invalid.isInvalid = true;
-
-                char op[100];
-                sprintf(op, "无效: %d→%d (%s)", from + 1, to + 1, invalidReason.c_str());
-                invalid.operation = op;
-                invalidStates.push_back(invalid);
+            vector<CorpusMove> solution(count);
+            for (int j = 0; j < count; j++) {
+                solution[j].from = moves[2 * j];
+                solution[j].to = moves[2 * j + 1];
             }
+            writer.append(old, solution);
         }
-    }
-
-    return nextStates;
-}
+    }   // 先解除映射，再替换原文件
 
-// 检查是否为目标状态（符合新规则）
-bool isGoalState(const GameState& state) {
-    // 1. 检查每种颜色是否只出现在一个瓶子中
-    map<int, int> colorToTubeMap; // 颜色 -> 瓶子索引
-    for (int i = 0; i < (int)state.tubes.size(); i++) {
-        const Tube& tube = state.tubes[i];
-        if (tube.isEmpty()) continue; // 空瓶跳过
-
-        // 检查瓶子内部是否只有一种颜色
-        if (!tube.isComplete()) return false;
-
-        int tubeColor = tube.colors[0];
-
-        // 检查该颜色是否已出现在其他瓶子
-        if (colorToTubeMap.find(tubeColor) != colorToTubeMap.end()) {
-            return false; // 该颜色已出现在其他瓶
+    bool appended;
+    if (solutionFound) {
+        vector<CorpusMove> solution;
+        for (size_t i = 1; i < solutionPath.size(); i++) {
+            CorpusMove move = { (uint8_t)solutionPath[i].moveFrom, (uint8_t)solutionPath[i].moveTo };
+            solution.push_back(move);
         }
-        colorToTubeMap[tubeColor] = i;
+        appended = writer.append(level, solution);
     }
-
-    // 2. 检查空瓶数量是否与初始状态一致
-    int currentEmpty = 0;
-    for (const auto& tube : state.tubes) {
-        if (tube.isEmpty()) currentEmpty++;
+    else {
+        appended = writer.append(level);
     }
-
-    return currentEmpty == initialEmptyTubes;
-}
-
-// 从路径中提取移动序列
-vector<string> extractMoveSequence(const vector<GameState>& path) {
-    vector<string> moves;
-
-    // 从第二个状态开始（第一个是初始状态）
-    for (size_t i = 1; i < path.size(); i++) {
-        moves.push_back(path[i].getMoveDescription());
+    int total = (int)writer.count();
+    if (!writer.close() || !appended) {
+        remove(tempPath.c_str());
+        sprintf(statusMessage, "保存到 %s 失败", CORPUS_FILE);
+        return;
     }
-
-    return moves;
+    remove(CORPUS_FILE);
+    if (rename(tempPath.c_str(), CORPUS_FILE) != 0) {
+        // 保留临时文件，其中已有全部关卡
+        sprintf(statusMessage, "替换 %s 失败，关卡保留在 %s", CORPUS_FILE, tempPath.c_str());
+        return;
+    }
+    sprintf(statusMessage, "已保存到 %s（共 %d 关%s）", CORPUS_FILE, total, solutionFound ? "，含解" : "");
 }
 
-// 打印解决方案到控制台
-void printSolutionToConsole(const vector<GameState>& path, const string& algorithm) {
-    if (path.empty()) return;
-
-    printf("\n================ %s算法求解完成 ================\n", algorithm.c_str());
-    printf("解决方案（共%d步）:\n", (int)path.size() - 1);
-    printf("==============================================\n");
-
-    for (size_t i = 1; i < path.size(); i++) {
-        printf("第%2d步: %s\n", (int)i, path[i].getMoveDescription().c_str());
+void loadLevelFromCorpus() {
+    CorpusReader corpus;
+    if (!corpus.open(CORPUS_FILE) || corpus.size() == 0) {
+        sprintf(statusMessage, "无法读取 %s", CORPUS_FILE);
+        return;
     }
-
-    printf("==============================================\n");
-    printf("初始状态:\n");
-    for (size_t i = 0; i < path[0].tubes.size(); i++) {
-        printf("  试管%d: ", (int)i + 1);
-        if (path[0].tubes[i].isEmpty()) {
-            printf("空");
-        }
-        else {
-            for (int color : path[0].tubes[i].colors) {
-                printf("%s ", GetColorName(color));
-            }
-        }
-        printf("\n");
+    size_t index = corpusCursor++ % corpus.size();
+    PackedState level;
+    if (!corpus.level(index, level)) {
+        sprintf(statusMessage, "%s 第 %d 关已损坏", CORPUS_FILE, (int)index + 1);
+        return;
     }
 
-    printf("\n最终状态:\n");
-    for (size_t i = 0; i < path.back().tubes.size(); i++) {
-        printf("  试管%d: ", (int)i + 1);
-        if (path.back().tubes[i].isEmpty()) {
-            printf("空");
+    clearSolution();
+    GameState state = unpackState(level);
+    state.operation = "初始状态";
+    state.hCost = state.calculateHeuristic();
+    initialEmptyTubes = countEmptyTubes(state);
+    solutionPath.clear();
+    solutionPath.push_back(state);
+
+    currentN = corpus.numTubes();
+    currentK = corpus.numColors();
+    currentM = corpus.capacity();
+    paramInputBoxes[0].text = to_string(currentN);
+    paramInputBoxes[1].text = to_string(currentK);
+    paramInputBoxes[2].text = to_string(currentM);
+
+    // 带解的关卡按规则重放出各步倒水量，得到完整解法路径
+    const uint8_t* moves;
+    int count = corpus.solution(index, moves);
+    if (count >= 0) {
+        vector<MoveRecord> records;
+        PackedState replay = level;
+        bool valid = true;
+        for (int j = 0; j < count && valid; j++) {
+            int from = moves[2 * j];
+            int to = moves[2 * j + 1];
+            int amount = from < replay.numTubes && to < replay.numTubes ? replay.pour(from, to) : 0;
+            MoveRecord record = { -1, (uint8_t)from, (uint8_t)to, (uint8_t)amount, 0 };
+            records.push_back(record);
+            valid = amount > 0;
         }
-        else {
-            for (int color : path.back().tubes[i].colors) {
-                printf("%s ", GetColorName(color));
-            }
+        if (valid && replay.isGoal(initialEmptyTubes)) {
+            replayMoves(state, records, solutionPath);
+            solutionFound = true;
         }
-        printf("\n");
     }
-    printf("==============================================\n\n");
+    sprintf(statusMessage, "已读取 %s 第 %d/%d 关%s", CORPUS_FILE, (int)index + 1, (int)corpus.size(),
+        solutionFound ? "，含解" : "");
 }
 
-// ==================== 算法实现 ====================
-bool BFS_Solve(const GameState& start) {
-    if (noSolution && start.isInvalid) return false;
-
-    auto startTime = high_resolution_clock::now();
-
-    queue<GameState*> q;
-    map<string, bool> visited;
-
-    GameState* startPtr = new GameState(start);
-    startPtr->operation = "初始状态";
-    startPtr->parent = NULL;
-    startPtr->gCost = 0;
-    startPtr->hCost = 0;
-    startPtr->moveFrom = -1;
-    startPtr->moveTo = -1;
-    startPtr->moveAmount = 0;
-    startPtr->isInvalid = false;
-
-    q.push(startPtr);
-    visited[startPtr->getKey()] = true;
-
-    totalStatesExplored = 0;
-    maxStatesInMemory = 0;
-    GameState* goalState = NULL;
-
-    while (!q.empty()) {
-        int currentQueueSize = (int)q.size();
-        maxStatesInMemory = max(maxStatesInMemory, currentQueueSize);
-
-        GameState* current = q.front();
-        q.pop();
-        totalStatesExplored++;
-
-        if (isGoalState(*current)) {
-            goalState = current;
-            break;
-        }
-
-        vector<GameState> invalidStates;
-        vector<GameState> nextStates = generateNextStates(*current, invalidStates);
-        for (size_t i = 0; i < nextStates.size(); i++) {
-            string key = nextStates[i].getKey();
-            if (visited.find(key) == visited.end()) {
-                GameState* nextPtr = new GameState(nextStates[i]);
-                nextPtr->parent = current;  // 设置父指针
-                visited[key] = true;
-                q.push(nextPtr);
-            }
-        }
+// ==================== 求解调度 ====================
+// 求解在工作线程中运行，界面线程每轮主循环轮询进度通道并按间隔重绘，搜索循环中不再绘图；
+// 求解结束后由界面线程把结果同步回界面使用的全局变量。求解期间界面只响应取消与退出。
+void startBackgroundSolve() {
+    if (isSolving || noSolution || solutionPath.empty()) return;
+    const GameState& start = solutionPath[currentStep];
+    if (start.isInvalid) return;
+
+    activeSolve.reset(new SolverContext());
+    SolverContext& ctx = *activeSolve;
+    ctx.initialEmptyTubes = initialEmptyTubes;
+    ctx.heuristic = currentHeuristic;
+    ctx.layeredBFS = layeredBFS;
+    ctx.searchThreads = parallelSearch ? 0 : 1;
+    ctx.portfolioQuality = portfolioQuality;
+    ctx.timeLimitMs = anytimeTimeLimitMs;
+    ctx.beamWidth = beamWidth;
+    ctx.memoryBudgetBytes = memoryBudgetMB << 20;
+    ctx.memoryAction = memoryAction;
+    ctx.cancelFlag = &cancelSolve;
+    ctx.progressChannel = &solveProgress;
+    ctx.onSolution = [](const vector<GameState>& path, double bound) {
+        // 在求解线程中调用，只把解交给界面线程，由 pollBackgroundSolve 显示
+        lock_guard<mutex> guard(anytimeLock);
+        anytimePath = path;
+        anytimePathBound = bound;
+        anytimePathPending = true;
+    };
+    {
+        lock_guard<mutex> guard(anytimeLock);
+        anytimePathPending = false;
+    }
+    anytimeBound = 0.0;
+    lastProgress = ProgressSnapshot();
+    solveProgress.start();
+    cancelSolve.store(false);
+    solverFinished.store(false);
+    isSolving = true;
+    selectedTube = -1;
+    highlightedTubes.clear();
+    sprintf(statusMessage, "%s算法求解中... (空格/X键取消)", currentAlgorithm.c_str());
+
+    string algorithm = currentAlgorithm;
+    GameState startState = start;
+    solverThread = thread([algorithm, startState]() {
+        solveSucceeded = SolveWithAlgorithm(algorithm, startState, *activeSolve);
+        solverFinished.store(true);
+    });
+}
 
-        sprintf(statusMessage, "BFS搜索中... 已探索: %d", totalStatesExplored);
+// 请求取消：求解线程在下一次检查时停止，结果仍由 pollBackgroundSolve 汇总
+void cancelBackgroundSolve() {
+    if (!isSolving) return;
+    cancelSolve.store(true);
+    sprintf(statusMessage, "正在取消%s求解...", currentAlgorithm.c_str());
+}
 
-        if (totalStatesExplored % 100 == 0) {
-            // 更新显示但不清除整个屏幕
-            settextcolor(RGB(240, 240, 240));
-            char progress[100];
-            sprintf(progress, "BFS搜索中... 已探索状态: %d", totalStatesExplored);
-            OutText(400, 100, progress, RGB(240, 240, 240), 24);
-            FlushBatchDraw();
-        }
+// 每轮主循环调用：求解结束时汇总结果，否则每 PROGRESS_REDRAW_MS 取一次最新进度与 ARA* 中间解；返回是否需要重绘
+bool pollBackgroundSolve() {
+    if (!isSolving) return false;
+    if (solverFinished.load()) {
+        finishBackgroundSolve();
+        return true;
     }
 
-    if (goalState != NULL) {
-        auto endTime = high_resolution_clock::now();
-        solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-        // 回溯构建路径
-        solutionPath.clear();
-        GameState* state = goalState;
-        while (state != NULL) {
-            solutionPath.insert(solutionPath.begin(), *state);
-            state = state->parent;
+    static DWORD lastPoll = 0;
+    DWORD now = GetTickCount();
+    if (now - lastPoll < PROGRESS_REDRAW_MS) return false;
+    lastPoll = now;
+
+    bool changed = false;
+    {
+        // ARA* 每得到更短的解立即显示，后续更优的解会覆盖它
+        lock_guard<mutex> guard(anytimeLock);
+        if (anytimePathPending) {
+            solutionPath = anytimePath;
+            anytimeBound = anytimePathBound;
+            currentStep = 0;
+            anytimePathPending = false;
+            changed = true;
         }
-
-        // 打印解决方案到控制台
-        printSolutionToConsole(solutionPath, "BFS");
-
-        // 记录算法统计
-        bfsStats.statesExplored = totalStatesExplored;
-        bfsStats.maxMemory = maxStatesInMemory;
-        bfsStats.solvingTime = solvingTime;
-        bfsStats.solutionLength = (int)solutionPath.size() - 1;
-        bfsStats.algorithmName = "BFS";
-        bfsStats.hasSolution = true;
-        bfsStats.solutionStatus = "有解";
-
-        return true;
     }
-
-    auto endTime = high_resolution_clock::now();
-    solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-    // 记录无解统计
-    bfsStats.statesExplored = totalStatesExplored;
-    bfsStats.maxMemory = maxStatesInMemory;
-    bfsStats.solvingTime = solvingTime;
-    bfsStats.solutionLength = 0;
-    bfsStats.algorithmName = "BFS";
-    bfsStats.hasSolution = false;
-    bfsStats.solutionStatus = "无解";
-
-    noSolution = true;
-    noSolutionReason = "无解：搜索后未找到解决方案";
-    showNoSolutionWarning = true;
-
-    return false;
-}
-
-bool DFS_Solve(const GameState& start) {
-    if (noSolution && start.isInvalid) return false;
-
-    auto startTime = high_resolution_clock::now();
-
-    stack<GameState*> s;
-    map<string, bool> visited;
-
-    GameState* startPtr = new GameState(start);
-    startPtr->operation = "初始状态";
-    startPtr->parent = NULL;
-    startPtr->gCost = 0;
-    startPtr->hCost = 0;
-    startPtr->moveFrom = -1;
-    startPtr->moveTo = -1;
-    startPtr->moveAmount = 0;
-    startPtr->isInvalid = false;
-
-    s.push(startPtr);
-    visited[startPtr->getKey()] = true;
-
-    totalStatesExplored = 0;
-    maxStatesInMemory = 0;
-    GameState* goalState = NULL;
-    int minSteps = INT_MAX;
-
-    while (!s.empty()) {
-        int currentStackSize = (int)s.size();
-        maxStatesInMemory = max(maxStatesInMemory, currentStackSize);
-
-        GameState* current = s.top();
-        s.pop();
-        totalStatesExplored++;
-
-        if (isGoalState(*current)) {
-            // DFS不一定找到最短路径，记录找到的第一个解
-            if (goalState == NULL || current->gCost < minSteps) {
-                goalState = current;
-                minSteps = current->gCost;
-            }
-            continue;  // 继续搜索可能找到更短路径
+    if (solveProgress.poll(lastProgress, progressSeen)) changed = true;
+    if (changed && !cancelSolve.load()) {
+        if (anytimeBound > 0) {
+            sprintf(statusMessage, "ARA*已得到 %d 步的解, 次优界 %.2f", (int)solutionPath.size() - 1, anytimeBound);
         }
-
-        vector<GameState> invalidStates;
-        vector<GameState> nextStates = generateNextStates(*current, invalidStates);
-        for (size_t i = 0; i < nextStates.size(); i++) {
-            string key = nextStates[i].getKey();
-            if (visited.find(key) == visited.end()) {
-                GameState* nextPtr = new GameState(nextStates[i]);
-                nextPtr->parent = current;
-                visited[key] = true;
-                s.push(nextPtr);
-            }
+        else {
+            sprintf(statusMessage, "%s搜索中... 已探索: %d", lastProgress.algorithm.c_str(), lastProgress.statesExplored);
         }
+    }
+    return changed;
+}
 
-        sprintf(statusMessage, "DFS搜索中... 已探索: %d", totalStatesExplored);
-
-        if (totalStatesExplored % 100 == 0) {
-            settextcolor(RGB(240, 240, 240));
-            char progress[100];
-            sprintf(progress, "DFS搜索中... 已探索状态: %d", totalStatesExplored);
-            OutText(400, 100, progress, RGB(240, 240, 240), 24);
-            FlushBatchDraw();
+// 求解线程结束后调用：同步结果并在控制台输出统计
+void finishBackgroundSolve() {
+    solverThread.join();
+    SolverContext& ctx = *activeSolve;
+    bool success = solveSucceeded;
+
+    totalStatesExplored = ctx.totalStatesExplored;
+    maxStatesInMemory = ctx.maxStatesInMemory;
+    peakMemoryBytes = ctx.peakMemoryBytes;
+    solvingTime = ctx.solvingTime;
+    lastMemoryAction = ctx.memoryActionTaken;
+
+    if (currentAlgorithm == "Portfolio") {
+        fillPortfolioStats(ctx);
+        if (ctx.portfolioWinner >= 0) {
+            printf("  组合求解采用: %s\n", GetPortfolioMemberName(ctx.portfolio[ctx.portfolioWinner]).c_str());
         }
     }
+    else {
+        statsForAlgorithm(currentAlgorithm) = ctx.stats;
+    }
+    if (ctx.threadsUsed > 1) {
+        printf("  并行线程: %d, 加速比: %.2f\n", ctx.threadsUsed, ctx.parallelSpeedup);
+    }
+    if (ctx.beamWidthUsed > 0) {
+        printf("  束宽度: %d\n", ctx.beamWidthUsed);
+    }
+    if (lastMemoryAction != MEMORY_NONE) {
+        printf("  内存预算: %lld MB, 已%s\n", memoryBudgetMB, GetMemoryActionName(lastMemoryAction));
+    }
+    if (ctx.suboptimalityBound > 0) {
+        anytimeBound = ctx.suboptimalityBound;
+        printf("  次优界: %.3f%s\n", ctx.suboptimalityBound, ctx.cancelled ? "" : (ctx.suboptimalityBound <= 1.0 ? " (已证明最优)" : " (达到时间上限)"));
+    }
 
-    if (goalState != NULL) {
-        auto endTime = high_resolution_clock::now();
-        solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-        // 回溯构建路径
-        solutionPath.clear();
-        GameState* state = goalState;
-        while (state != NULL) {
-            solutionPath.insert(solutionPath.begin(), *state);
-            state = state->parent;
-        }
+    if (success) {
+        solutionPath = ctx.solutionPath;
+        currentStep = 0;
+        solutionFound = true;
+        sprintf(statusMessage, "%s算法求解完成! 步数: %d", currentAlgorithm.c_str(), (int)solutionPath.size() - 1);
+        appendMemoryNote();
 
         // 打印解决方案到控制台
-        printSolutionToConsole(solutionPath, "DFS");
-
-        // 记录算法统计
-        dfsStats.statesExplored = totalStatesExplored;
-        dfsStats.maxMemory = maxStatesInMemory;
-        dfsStats.solvingTime = solvingTime;
-        dfsStats.solutionLength = (int)solutionPath.size() - 1;
-        dfsStats.algorithmName = "DFS";
-        dfsStats.hasSolution = true;
-        dfsStats.solutionStatus = "有解";
-
-        return true;
+        printSolutionToConsole(solutionPath, currentAlgorithm);
+
+        // 在控制台显示统计信息
+        printf("\n算法统计信息:\n");
+        printf("  算法: %s\n", currentAlgorithm.c_str());
+        printf("  探索状态数: %d\n", totalStatesExplored);
+        printf("  最大内存状态: %d\n", maxStatesInMemory);
+        printf("  峰值内存: %lld KB\n", peakMemoryBytes / 1024);
+        printPruneStats();
+        printf("  求解时间: %lld ms\n", solvingTime);
+        printf("  解决方案步数: %d\n", (int)solutionPath.size() - 1);
+    }
+    else if (ctx.cancelled) {
+        // 取消不说明关卡无解，之后仍可再次求解
+        sprintf(statusMessage, "已取消%s求解, 已探索: %d", currentAlgorithm.c_str(), totalStatesExplored);
+        printf("\n%s算法求解已取消\n", currentAlgorithm.c_str());
+        printf("  探索状态数: %d\n", totalStatesExplored);
+        printf("  求解时间: %lld ms\n", solvingTime);
     }
+    else {
+        noSolution = true;
+        noSolutionReason = ctx.noSolutionReason;
+        showNoSolutionWarning = true;
 
-    auto endTime = high_resolution_clock::now();
-    solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-    // 记录无解统计
-    dfsStats.statesExplored = totalStatesExplored;
-    dfsStats.maxMemory = maxStatesInMemory;
-    dfsStats.solvingTime = solvingTime;
-    dfsStats.solutionLength = 0;
-    dfsStats.algorithmName = "DFS";
-    dfsStats.hasSolution = false;
-    dfsStats.solutionStatus = "无解";
-
-    noSolution = true;
-    noSolutionReason = "无解：搜索后未找到解决方案";
-    showNoSolutionWarning = true;
-
-    return false;
-}
-
-// A*算法比较结构体
-struct AStarCompare {
-    bool operator()(const GameState* a, const GameState* b) const {
-        // 首先比较f值，如果相同则比较h值
-        int f1 = a->gCost + a->hCost;
-        int f2 = b->gCost + b->hCost;
-        if (f1 != f2) return f1 > f2;
-        return a->hCost > b->hCost;  // 倾向于h值更小的状态
+        printf("\n%s算法未找到解决方案\n", currentAlgorithm.c_str());
+        printf("  原因: %s\n", noSolutionReason.c_str());
+        printf("  探索状态数: %d\n", totalStatesExplored);
+        printf("  求解时间: %lld ms\n", solvingTime);
     }
-};
-
-bool AStar_Solve(const GameState& start) {
-    if (noSolution && start.isInvalid) return false;
-
-    auto startTime = high_resolution_clock::now();
-
-    priority_queue<GameState*, vector<GameState*>, AStarCompare> pq;
-    map<string, int> visited;  // 记录每个状态的最小gCost
-
-    GameState* startPtr = new GameState(start);
-    startPtr->operation = "初始状态";
-    startPtr->parent = NULL;
-    startPtr->gCost = 0;
-    startPtr->hCost = startPtr->calculateHeuristic();
-    startPtr->moveFrom = -1;
-    startPtr->moveTo = -1;
-    startPtr->moveAmount = 0;
-    startPtr->isInvalid = false;
-
-    pq.push(startPtr);
-    visited[startPtr->getKey()] = startPtr->gCost;
-
-    totalStatesExplored = 0;
-    maxStatesInMemory = 0;
-    GameState* goalState = NULL;
-
-    while (!pq.empty()) {
-        int currentQueueSize = (int)pq.size();
-        maxStatesInMemory = max(maxStatesInMemory, currentQueueSize);
-
-        GameState* current = pq.top();
-        pq.pop();
-        totalStatesExplored++;
-
-        // 验证当前状态是否是最优路径上的（不是被更优路径取代的）
-        if (visited[current->getKey()] < current->gCost) {
-            continue;
-        }
-
-        if (isGoalState(*current)) {
-            goalState = current;
-            break;
-        }
-
-        vector<GameState> invalidStates;
-        vector<GameState> nextStates = generateNextStates(*current, invalidStates);
-        for (size_t i = 0; i < nextStates.size(); i++) {
-            string key = nextStates[i].getKey();
-            int newGCost = current->gCost + 1;
-
-            if (visited.find(key) == visited.end() || newGCost < visited[key]) {
-                GameState* nextPtr = new GameState(nextStates[i]);
-                nextPtr->parent = current;
-                nextPtr->gCost = newGCost;
-                nextPtr->hCost = nextPtr->calculateHeuristic();
-
-                visited[key] = newGCost;
-                pq.push(nextPtr);
-            }
-        }
+    activeSolve.reset();
+    isSolving = false;
+}
 
-        sprintf(statusMessage, "A*搜索中... 已探索: %d", totalStatesExplored);
+// 各算法在性能对比面板中的统计行
+AlgorithmStats& statsForAlgorithm(const string& algorithm) {
+    if (algorithm == "BFS") return bfsStats;
+    if (algorithm == "DFS") return dfsStats;
+    if (algorithm == "IDA*") return idaStats;
+    if (algorithm == "ARA*") return araStats;
+    if (algorithm == "Beam") return beamStats;
+    return astarStats;
+}
 
-        if (totalStatesExplored % 100 == 0) {
-            settextcolor(RGB(240, 240, 240));
-            char progress[100];
-            sprintf(progress, "A*搜索中... 已探索状态: %d", totalStatesExplored);
-            OutText(400, 100, progress, RGB(240, 240, 240), 24);
-            FlushBatchDraw();
+// 组合求解后按成员填充性能对比面板：每个算法行取该算法的一个成员，胜出的成员优先
+void fillPortfolioStats(const SolverContext& ctx) {
+    vector<AlgorithmStats*> filled;
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t i = 0; i < ctx.portfolio.size(); i++) {
+            bool isWinner = (int)i == ctx.portfolioWinner;
+            if ((pass == 0) != isWinner) continue;
+            AlgorithmStats& row = statsForAlgorithm(ctx.portfolio[i].algorithm);
+            if (find(filled.begin(), filled.end(), &row) != filled.end()) continue;
+            row = ctx.portfolioStats[i];
+            filled.push_back(&row);
         }
     }
+}
 
-    if (goalState != NULL) {
-        auto endTime = high_resolution_clock::now();
-        solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-        // 回溯构建路径
-        solutionPath.clear();
-        GameState* state = goalState;
-        while (state != NULL) {
-            solutionPath.insert(solutionPath.begin(), *state);
-            state = state->parent;
-        }
-
-        // 打印解决方案到控制台
-        printSolutionToConsole(solutionPath, "A*");
-
-        // 记录算法统计
-        astarStats.statesExplored = totalStatesExplored;
-        astarStats.maxMemory = maxStatesInMemory;
-        astarStats.solvingTime = solvingTime;
-        astarStats.solutionLength = (int)solutionPath.size() - 1;
-        astarStats.algorithmName = "A*";
-        astarStats.hasSolution = true;
-        astarStats.solutionStatus = "有解";
+// 求解触发了内存预算时，在状态栏后注明预算与采取的处理
+void appendMemoryNote() {
+    if (lastMemoryAction == MEMORY_NONE) return;
+    char note[60];
+    sprintf(note, " (内存%lldMB:%s)", memoryBudgetMB, GetMemoryActionName(lastMemoryAction));
+    if (strlen(statusMessage) + strlen(note) < sizeof(statusMessage)) strcat(statusMessage, note);
+}
 
-        return true;
+// 在控制台显示当前算法各剪枝规则去掉的后继数
+void printPruneStats() {
+    const AlgorithmStats& stats = statsForAlgorithm(currentAlgorithm);
+    printf("  剪枝统计:");
+    for (int i = 0; i < PRUNE_RULE_COUNT; i++) {
+        printf(" %s=%lld", GetPruneRuleName(i), stats.prunedByRule[i]);
     }
-
-    auto endTime = high_resolution_clock::now();
-    solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
-
-    // 记录无解统计
-    astarStats.statesExplored = totalStatesExplored;
-    astarStats.maxMemory = maxStatesInMemory;
-    astarStats.solvingTime = solvingTime;
-    astarStats.solutionLength = 0;
-    astarStats.algorithmName = "A*";
-    astarStats.hasSolution = false;
-    astarStats.solutionStatus = "无解";
-
-    noSolution = true;
-    noSolutionReason = "无解：搜索后未找到解决方案";
-    showNoSolutionWarning = true;
-
-    return false;
+    printf("\n");
 }
 
 // ==================== 绘图函数 ====================
@@ -1249,7 +973,22 @@ void drawInfoPanel() {
     }
     OutText(INFO_PANEL_X + 20, y, stepInfo, RGB(240, 240, 240), 20);
 
-    if (solutionFound) {
+    if (isSolving) {
+        // 求解线程最近发布的进度快照
+        char progressInfo[100];
+        y += 35;
+        sprintf(progressInfo, "已探索: %d", lastProgress.statesExplored);
+        OutText(INFO_PANEL_X + 20, y, progressInfo, RGB(200, 200, 240), 20);
+
+        y += 35;
+        sprintf(progressInfo, "待扩展: %d", lastProgress.frontierSize);
+        OutText(INFO_PANEL_X + 20, y, progressInfo, RGB(200, 200, 240), 20);
+
+        y += 35;
+        sprintf(progressInfo, "用时: %lld ms, %.0f 状态/秒", lastProgress.elapsedMs, lastProgress.statesPerSecond);
+        OutText(INFO_PANEL_X + 20, y, progressInfo, RGB(200, 200, 240), 20);
+    }
+    else if (solutionFound) {
         y += 35;
         char stateInfo[100];
         sprintf(stateInfo, "探索状态: %d", totalStatesExplored);
@@ -1257,7 +996,7 @@ void drawInfoPanel() {
 
         y += 35;
         char memInfo[100];
-        sprintf(memInfo, "最大内存: %d", maxStatesInMemory);
+        sprintf(memInfo, "最大内存: %lld KB", peakMemoryBytes / 1024);
         OutText(INFO_PANEL_X + 20, y, memInfo, RGB(200, 200, 240), 20);
 
         y += 35;
@@ -1294,12 +1033,18 @@ void drawInfoPanel() {
     int buttonHeight = 40;
     int buttonSpacing = 18;
 
-    // 求解按钮
+    // 求解按钮，求解期间为取消按钮
     bool canSolve = !noSolution && !solutionPath.empty();
-    drawButton(INFO_PANEL_X + 20, y, buttonWidth, buttonHeight,
-        "自动求解", false,
-        canSolve ? RGB(70, 130, 180) : RGB(80, 80, 100),
-        canSolve ? RGB(240, 240, 240) : RGB(180, 180, 180), 18);
+    if (isSolving) {
+        drawButton(INFO_PANEL_X + 20, y, buttonWidth, buttonHeight,
+            "取消求解", false, RGB(180, 80, 70), RGB(240, 240, 240), 18);
+    }
+    else {
+        drawButton(INFO_PANEL_X + 20, y, buttonWidth, buttonHeight,
+            "自动求解", false,
+            canSolve ? RGB(70, 130, 180) : RGB(80, 80, 100),
+            canSolve ? RGB(240, 240, 240) : RGB(180, 180, 180), 18);
+    }
 
     // 上一步按钮
     bool canPrev = (currentStep > 0);
@@ -1337,21 +1082,63 @@ void drawInfoPanel() {
     // BFS算法按钮
     COLORREF bfsBgColor = currentAlgorithm == "BFS" ? RGB(100, 170, 230) : RGB(70, 130, 180);
     COLORREF bfsTextColor = currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240);
-    drawButton(INFO_PANEL_X + 20, y, 80, 35, "BFS", currentAlgorithm == "BFS",
+    drawButton(INFO_PANEL_X + 20, y, 62, 35, "BFS", currentAlgorithm == "BFS",
         bfsBgColor, bfsTextColor, 18);
 
     // DFS算法按钮
     COLORREF dfsBgColor = currentAlgorithm == "DFS" ? RGB(100, 170, 230) : RGB(70, 130, 180);
     COLORREF dfsTextColor = currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240);
-    drawButton(INFO_PANEL_X + 110, y, 80, 35, "DFS", currentAlgorithm == "DFS",
+    drawButton(INFO_PANEL_X + 88, y, 62, 35, "DFS", currentAlgorithm == "DFS",
         dfsBgColor, dfsTextColor, 18);
 
     // A*算法按钮
     COLORREF astarBgColor = currentAlgorithm == "A*" ? RGB(100, 170, 230) : RGB(70, 130, 180);
     COLORREF astarTextColor = currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240);
-    drawButton(INFO_PANEL_X + 200, y, 80, 35, "A*", currentAlgorithm == "A*",
+    drawButton(INFO_PANEL_X + 156, y, 62, 35, "A*", currentAlgorithm == "A*",
         astarBgColor, astarTextColor, 18);
 
+    // IDA*算法按钮
+    COLORREF idaBgColor = currentAlgorithm == "IDA*" ? RGB(100, 170, 230) : RGB(70, 130, 180);
+    COLORREF idaTextColor = currentAlgorithm == "IDA*" ? RGB(255, 255, 150) : RGB(240, 240, 240);
+    drawButton(INFO_PANEL_X + 224, y, 62, 35, "IDA*", currentAlgorithm == "IDA*",
+        idaBgColor, idaTextColor, 18);
+
+}
+
+// 性能对比面板中的一行：名称、状态数、内存、时间、步数、状态
+void drawAlgorithmStatsRow(int panelX, int y, const char* name, const AlgorithmStats& stats) {
+    bool isCurrent = currentAlgorithm == name;
+    COLORREF textColor = isCurrent ? RGB(255, 255, 150) : RGB(240, 240, 240);
+    OutText(panelX + 20, y, name, textColor, 20);
+
+    if (stats.statesExplored > 0) {
+        char buf[100];
+        sprintf(buf, "%d", stats.statesExplored);
+        OutText(panelX + 100, y, buf, textColor, 20);
+        sprintf(buf, "%lld", stats.peakMemoryBytes / 1024);
+        OutText(panelX + 200, y, buf, textColor, 20);
+        sprintf(buf, "%lld", stats.solvingTime);
+        OutText(panelX + 300, y, buf, textColor, 20);
+
+        if (stats.hasSolution) {
+            sprintf(buf, "%d", stats.solutionLength);
+            OutText(panelX + 420, y, buf, textColor, 20);
+            string status = stats.solutionStatus;
+            if (stats.memoryAction != MEMORY_NONE) status += string("·") + GetMemoryActionName(stats.memoryAction);
+            OutText(panelX + 500, y, status.c_str(), RGB(100, 255, 100), 20);
+        }
+        else {
+            OutText(panelX + 420, y, "-", RGB(255, 150, 150), 20);
+            OutText(panelX + 500, y, stats.solutionStatus.c_str(), RGB(255, 100, 100), 20);
+        }
+    }
+    else {
+        OutText(panelX + 100, y, "-", RGB(150, 150, 150), 20);
+        OutText(panelX + 200, y, "-", RGB(150, 150, 150), 20);
+        OutText(panelX + 300, y, "-", RGB(150, 150, 150), 20);
+        OutText(panelX + 420, y, "-", RGB(150, 150, 150), 20);
+        OutText(panelX + 500, y, "未运行", RGB(150, 150, 150), 20);
+    }
 }
 
 void drawParameterPanel() {
@@ -1416,133 +1203,59 @@ void drawAlgorithmPanel() {
     int y = panelY + 45;
     OutText(panelX + 20, y, "算法", RGB(255, 255, 200), 20);
     OutText(panelX + 100, y, "状态数", RGB(255, 255, 200), 20);
-    OutText(panelX + 200, y, "内存", RGB(255, 255, 200), 20);
+    OutText(panelX + 200, y, "内存(KB)", RGB(255, 255, 200), 20);
     OutText(panelX + 300, y, "时间(ms)", RGB(255, 255, 200), 20);
     OutText(panelX + 420, y, "步数", RGB(255, 255, 200), 20);
     OutText(panelX + 500, y, "状态", RGB(255, 255, 200), 20);
 
     y += 35;
 
-    // BFS统计
-    OutText(panelX + 20, y, "BFS",
-        currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-    if (bfsStats.statesExplored > 0) {
-        char buf[100];
-        sprintf(buf, "%d", bfsStats.statesExplored);
-        OutText(panelX + 100, y, buf,
-            currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%d", bfsStats.maxMemory);
-        OutText(panelX + 200, y, buf,
-            currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%lld", bfsStats.solvingTime);
-        OutText(panelX + 300, y, buf,
-            currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-
-        if (bfsStats.hasSolution) {
-            sprintf(buf, "%d", bfsStats.solutionLength);
-            OutText(panelX + 420, y, buf,
-                currentAlgorithm == "BFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-            OutText(panelX + 500, y, bfsStats.solutionStatus.c_str(),
-                currentAlgorithm == "BFS" ? RGB(100, 255, 100) : RGB(100, 255, 100), 20);
-        }
-        else {
-            OutText(panelX + 420, y, "-",
-                currentAlgorithm == "BFS" ? RGB(255, 150, 150) : RGB(255, 150, 150), 20);
-            OutText(panelX + 500, y, bfsStats.solutionStatus.c_str(),
-                currentAlgorithm == "BFS" ? RGB(255, 100, 100) : RGB(255, 100, 100), 20);
-        }
-    }
-    else {
-        OutText(panelX + 100, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 200, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 300, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 420, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 500, y, "未运行", RGB(150, 150, 150), 20);
-    }
-
+    drawAlgorithmStatsRow(panelX, y, "BFS", bfsStats);
+    y += 35;
+    drawAlgorithmStatsRow(panelX, y, "DFS", dfsStats);
     y += 35;
+    drawAlgorithmStatsRow(panelX, y, "A*", astarStats);
+    y += 35;
+    drawAlgorithmStatsRow(panelX, y, "IDA*", idaStats);
+    y += 35;
+    drawAlgorithmStatsRow(panelX, y, "ARA*", araStats);
+    y += 35;
+    drawAlgorithmStatsRow(panelX, y, "Beam", beamStats);
 
-    // DFS统计
-    OutText(panelX + 20, y, "DFS",
-        currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-    if (dfsStats.statesExplored > 0) {
-        char buf[100];
-        sprintf(buf, "%d", dfsStats.statesExplored);
-        OutText(panelX + 100, y, buf,
-            currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%d", dfsStats.maxMemory);
-        OutText(panelX + 200, y, buf,
-            currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%lld", dfsStats.solvingTime);
-        OutText(panelX + 300, y, buf,
-            currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-
-        if (dfsStats.hasSolution) {
-            sprintf(buf, "%d", dfsStats.solutionLength);
-            OutText(panelX + 420, y, buf,
-                currentAlgorithm == "DFS" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-            OutText(panelX + 500, y, dfsStats.solutionStatus.c_str(),
-                currentAlgorithm == "DFS" ? RGB(100, 255, 100) : RGB(100, 255, 100), 20);
-        }
-        else {
-            OutText(panelX + 420, y, "-",
-                currentAlgorithm == "DFS" ? RGB(255, 150, 150) : RGB(255, 150, 150), 20);
-            OutText(panelX + 500, y, dfsStats.solutionStatus.c_str(),
-                currentAlgorithm == "DFS" ? RGB(255, 100, 100) : RGB(255, 100, 100), 20);
-        }
+    // 当前算法提示
+    y += 45;
+    char currentAlgMsg[100];
+    if (currentAlgorithm == "A*") {
+        sprintf(currentAlgMsg, "当前算法: A* (启发: %s%s, H/P键切换)", GetHeuristicName(currentHeuristic),
+            parallelSearch ? ", HDA*并行" : "");
     }
-    else {
-        OutText(panelX + 100, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 200, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 300, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 420, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 500, y, "未运行", RGB(150, 150, 150), 20);
+    else if (currentAlgorithm == "IDA*") {
+        sprintf(currentAlgMsg, "当前算法: IDA* (启发: %s, H键切换)", GetHeuristicName(currentHeuristic));
     }
-
-    y += 35;
-
-    // A*统计
-    OutText(panelX + 20, y, "A*",
-        currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-    if (astarStats.statesExplored > 0) {
-        char buf[100];
-        sprintf(buf, "%d", astarStats.statesExplored);
-        OutText(panelX + 100, y, buf,
-            currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%d", astarStats.maxMemory);
-        OutText(panelX + 200, y, buf,
-            currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-        sprintf(buf, "%lld", astarStats.solvingTime);
-        OutText(panelX + 300, y, buf,
-            currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-
-        if (astarStats.hasSolution) {
-            sprintf(buf, "%d", astarStats.solutionLength);
-            OutText(panelX + 420, y, buf,
-                currentAlgorithm == "A*" ? RGB(255, 255, 150) : RGB(240, 240, 240), 20);
-            OutText(panelX + 500, y, astarStats.solutionStatus.c_str(),
-                currentAlgorithm == "A*" ? RGB(100, 255, 100) : RGB(100, 255, 100), 20);
+    else if (currentAlgorithm == "ARA*") {
+        if (anytimeBound > 0) {
+            sprintf(currentAlgMsg, "当前算法: ARA* (启发: %s, 次优界: %.2f%s)", GetHeuristicName(currentHeuristic),
+                anytimeBound, anytimeBound <= 1.0 ? " 最优" : "");
         }
         else {
-            OutText(panelX + 420, y, "-",
-                currentAlgorithm == "A*" ? RGB(255, 150, 150) : RGB(255, 150, 150), 20);
-            OutText(panelX + 500, y, astarStats.solutionStatus.c_str(),
-                currentAlgorithm == "A*" ? RGB(255, 100, 100) : RGB(255, 100, 100), 20);
+            sprintf(currentAlgMsg, "当前算法: ARA* (启发: %s, H键切换)", GetHeuristicName(currentHeuristic));
         }
     }
+    else if (currentAlgorithm == "Beam") {
+        sprintf(currentAlgMsg, "当前算法: 束搜索 (宽度 %d, 不保证最短)", beamWidth);
+    }
+    else if (currentAlgorithm == "Portfolio") {
+        sprintf(currentAlgMsg, "当前算法: 组合竞速 (%s, Q键切换)",
+            portfolioQuality == QUALITY_OPTIMAL ? "只接受最优解" : "接受任意解");
+    }
+    else if (currentAlgorithm == "BFS") {
+        sprintf(currentAlgMsg, "当前算法: BFS (%s, L/P键切换)",
+            layeredBFS ? "分层批量去重" : (parallelSearch ? "多线程并行" : "哈希去重"));
+    }
     else {
-        OutText(panelX + 100, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 200, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 300, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 420, y, "-", RGB(150, 150, 150), 20);
-        OutText(panelX + 500, y, "未运行", RGB(150, 150, 150), 20);
+        sprintf(currentAlgMsg, "当前算法: %s", currentAlgorithm.c_str());
     }
 
-    // 当前算法提示
-    y += 45;
-    char currentAlgMsg[100];
-    sprintf(currentAlgMsg, "当前算法: %s", currentAlgorithm.c_str());
-
     // 根据当前算法改变提示颜色
     COLORREF currentAlgColor;
     if (currentAlgorithm == "BFS") currentAlgColor = RGB(150, 200, 255);
@@ -1703,7 +1416,7 @@ void handleTubeClick(int tubeIndex) {
                 sprintf(statusMessage, "从 %d 倒入 %d", from + 1, to + 1);
 
                 // 检查是否胜利
-                if (isGoalState(newState)) {
+                if (isGoalState(newState, initialEmptyTubes)) {
                     sprintf(statusMessage, "胜利! 关卡完成!");
                     solutionFound = true;
                 }
@@ -1771,9 +1484,12 @@ int main() {
     solutionPath.push_back(initialState);
 
     // 初始化算法统计
-    bfsStats = { 0, 0, 0, 0, "BFS", false, "未运行" };
-    dfsStats = { 0, 0, 0, 0, "DFS", false, "未运行" };
-    astarStats = { 0, 0, 0, 0, "A*", false, "未运行" };
+    bfsStats = AlgorithmStats("BFS");
+    dfsStats = AlgorithmStats("DFS");
+    astarStats = AlgorithmStats("A*");
+    idaStats = AlgorithmStats("IDA*");
+    araStats = AlgorithmStats("ARA*");
+    beamStats = AlgorithmStats("Beam");
 
     // 绘制初始界面
     drawCurrentState(initialState);
@@ -1788,6 +1504,7 @@ int main() {
     printf("3. 选择算法后点击'自动求解'\n");
     printf("4. 支持无解场景提示与可视化\n");
     printf("5. 支持动态转移演示和步骤回溯\n");
+    printf("6. 求解在后台进行，空格/X键或'取消求解'按钮可中止\n");
     printf("==============================================\n\n");
     printf("当前参数：水壶数=%d, 颜色数=%d, 容量=%d\n", currentN, currentK, currentM);
 
@@ -1797,7 +1514,15 @@ int main() {
         if (MouseHit()) {
             MOUSEMSG msg = GetMouseMsg();
 
-            if (msg.uMsg == WM_LBUTTONDOWN) {
+            if (msg.uMsg == WM_LBUTTONDOWN && isSolving) {
+                // 求解期间只响应求解按钮（此时为取消）
+                if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 20, SCREEN_HEIGHT - 420, 120, 40)) {
+                    cancelBackgroundSolve();
+                    drawCurrentState(solutionPath[currentStep]);
+                    FlushBatchDraw();
+                }
+            }
+            else if (msg.uMsg == WM_LBUTTONDOWN) {
                 // 首先检查是否点击了输入框
                 bool inputBoxClicked = false;
                 for (size_t i = 0; i < paramInputBoxes.size(); i++) {
@@ -1842,26 +1567,33 @@ int main() {
                 int algorithmButtonY = SCREEN_HEIGHT - 420 + 3 * (40 + 18) + 45;
 
                 // BFS算法按钮
-                if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 20, algorithmButtonY, 80, 35)) {
+                if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 20, algorithmButtonY, 62, 35)) {
                     currentAlgorithm = "BFS";
                     drawCurrentState(solutionPath[currentStep]);
                     FlushBatchDraw();
                     continue;
                 }
                 // DFS算法按钮
-                else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 110, algorithmButtonY, 80, 35)) {
+                else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 88, algorithmButtonY, 62, 35)) {
                     currentAlgorithm = "DFS";
                     drawCurrentState(solutionPath[currentStep]);
                     FlushBatchDraw();
                     continue;
                 }
                 // A*算法按钮
-                else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 200, algorithmButtonY, 80, 35)) {
+                else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 156, algorithmButtonY, 62, 35)) {
                     currentAlgorithm = "A*";
                     drawCurrentState(solutionPath[currentStep]);
                     FlushBatchDraw();
                     continue;
                 }
+                // IDA*算法按钮
+                else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 224, algorithmButtonY, 62, 35)) {
+                    currentAlgorithm = "IDA*";
+                    drawCurrentState(solutionPath[currentStep]);
+                    FlushBatchDraw();
+                    continue;
+                }
 
                 // 检查其他按钮点击
                 int buttonWidth = 120;
@@ -1871,50 +1603,9 @@ int main() {
 
                 // 自动求解按钮
                 if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + 20, buttonY, buttonWidth, buttonHeight)) {
-                    if (!isSolving && !noSolution) {
-                        isSolving = true;
-                        sprintf(statusMessage, "%s算法求解中...", currentAlgorithm.c_str());
-                        drawCurrentState(solutionPath[currentStep]);
-                        FlushBatchDraw();
-
-                        bool success = false;
-                        if (currentAlgorithm == "BFS") {
-                            success = BFS_Solve(solutionPath[currentStep]);
-                        }
-                        else if (currentAlgorithm == "DFS") {
-                            success = DFS_Solve(solutionPath[currentStep]);
-                        }
-                        else if (currentAlgorithm == "A*") {
-                            success = AStar_Solve(solutionPath[currentStep]);
-                        }
-
-                        if (success) {
-                            sprintf(statusMessage, "%s算法求解完成! 步数: %d",
-                                currentAlgorithm.c_str(), (int)solutionPath.size() - 1);
-                            currentStep = 0;
-                            solutionFound = true;
-
-                            // 在控制台显示统计信息
-                            printf("\n算法统计信息:\n");
-                            printf("  算法: %s\n", currentAlgorithm.c_str());
-                            printf("  探索状态数: %d\n", totalStatesExplored);
-                            printf("  最大内存状态: %d\n", maxStatesInMemory);
-                            printf("  求解时间: %lld ms\n", solvingTime);
-                            printf("  解决方案步数: %d\n", (int)solutionPath.size() - 1);
-                        }
-                        else {
-                            printf("\n%s算法未找到解决方案\n", currentAlgorithm.c_str());
-                            printf("  原因: %s\n", noSolutionReason.c_str());
-                            printf("  探索状态数: %d\n", totalStatesExplored);
-                            printf("  求解时间: %lld ms\n", solvingTime);
-                        }
-                        isSolving = false;
-                        selectedTube = -1;
-                        highlightedTubes.clear();
-
-                        drawCurrentState(solutionPath[currentStep]);
-                        FlushBatchDraw();
-                    }
+                    startBackgroundSolve();
+                    drawCurrentState(solutionPath[currentStep]);
+                    FlushBatchDraw();
                 }
                 // 上一步按钮
                 else if (isPointInButton(msg.x, msg.y, INFO_PANEL_X + INFO_PANEL_WIDTH - buttonWidth - 20,
@@ -2006,8 +1697,18 @@ int main() {
             int key = _getch();
             bool needRedraw = false;
 
+            if (isSolving) {
+                // 求解期间只响应取消与退出
+                if (key == 27) { // ESC键: 取消求解并退出
+                    break;
+                }
+                else if (key == ' ' || key == 'x' || key == 'X') { // 空格/X键: 取消求解
+                    cancelBackgroundSolve();
+                    needRedraw = true;
+                }
+            }
             // 检查是否有激活的输入框
-            if (activeInputBoxIndex != -1 && activeInputBoxIndex < (int)paramInputBoxes.size()) {
+            else if (activeInputBoxIndex != -1 && activeInputBoxIndex < (int)paramInputBoxes.size()) {
                 if (key == 13) { // Enter键 - 确认输入
                     paramInputBoxes[activeInputBoxIndex].deactivate();
                     activeInputBoxIndex = -1;
@@ -2046,49 +1747,9 @@ int main() {
                         needRedraw = true;
                     }
                 }
-                else if (key == ' ') { // 空格键: 自动求解
-                    if (!isSolving && !noSolution) {
-                        isSolving = true;
-                        sprintf(statusMessage, "%s算法求解中...", currentAlgorithm.c_str());
-                        drawCurrentState(solutionPath[currentStep]);
-                        FlushBatchDraw();
-
-                        bool success = false;
-                        if (currentAlgorithm == "BFS") {
-                            success = BFS_Solve(solutionPath[currentStep]);
-                        }
-                        else if (currentAlgorithm == "DFS") {
-                            success = DFS_Solve(solutionPath[currentStep]);
-                        }
-                        else if (currentAlgorithm == "A*") {
-                            success = AStar_Solve(solutionPath[currentStep]);
-                        }
-
-                        if (success) {
-                            sprintf(statusMessage, "%s算法求解完成! 步数: %d",
-                                currentAlgorithm.c_str(), (int)solutionPath.size() - 1);
-                            currentStep = 0;
-                            solutionFound = true;
-
-                            // 在控制台显示统计信息
-                            printf("\n算法统计信息:\n");
-                            printf("  算法: %s\n", currentAlgorithm.c_str());
-                            printf("  探索状态数: %d\n", totalStatesExplored);
-                            printf("  最大内存状态: %d\n", maxStatesInMemory);
-                            printf("  求解时间: %lld ms\n", solvingTime);
-                            printf("  解决方案步数: %d\n", (int)solutionPath.size() - 1);
-                        }
-                        else {
-                            printf("\n%s算法未找到解决方案\n", currentAlgorithm.c_str());
-                            printf("  原因: %s\n", noSolutionReason.c_str());
-                            printf("  探索状态数: %d\n", totalStatesExplored);
-                            printf("  求解时间: %lld ms\n", solvingTime);
-                        }
-                        isSolving = false;
-                        selectedTube = -1;
-                        highlightedTubes.clear();
-                        needRedraw = true;
-                    }
+                else if (key == ' ') { // 空格键: 自动求解（求解期间为取消）
+                    startBackgroundSolve();
+                    needRedraw = true;
                 }
                 else if (key == 'r' || key == 'R') { // R键: 重置
                     resetGame();
@@ -2124,6 +1785,14 @@ int main() {
                     }
                     needRedraw = true;
                 }
+                else if (key == 's' || key == 'S') { // S键: 把当前关卡追加到语料库
+                    saveLevelToCorpus();
+                    needRedraw = true;
+                }
+                else if (key == 'o' || key == 'O') { // O键: 依次读取语料库中的关卡
+                    loadLevelFromCorpus();
+                    needRedraw = true;
+                }
                 else if (key == 'c' || key == 'C') { // C键: 清除解
                     clearSolution();
                     needRedraw = true;
@@ -2140,6 +1809,52 @@ int main() {
                     currentAlgorithm = "A*";
                     needRedraw = true;
                 }
+                else if (key == '4') { // 4键: 选择IDA*算法
+                    currentAlgorithm = "IDA*";
+                    needRedraw = true;
+                }
+                else if (key == '5') { // 5键: 选择组合求解
+                    currentAlgorithm = "Portfolio";
+                    needRedraw = true;
+                }
+                else if (key == '6') { // 6键: 选择ARA*算法
+                    currentAlgorithm = "ARA*";
+                    needRedraw = true;
+                }
+                else if (key == '7') { // 7键: 选择束搜索
+                    currentAlgorithm = "Beam";
+                    needRedraw = true;
+                }
+                else if (key == 'q' || key == 'Q') { // Q键: 切换组合求解的质量要求
+                    portfolioQuality = portfolioQuality == QUALITY_OPTIMAL ? QUALITY_ANY : QUALITY_OPTIMAL;
+                    sprintf(statusMessage, "组合求解: %s", portfolioQuality == QUALITY_OPTIMAL ? "只接受最优解" : "接受任意解");
+                    needRedraw = true;
+                }
+                else if (key == 'l' || key == 'L') { // L键: 切换BFS去重方式
+                    layeredBFS = !layeredBFS;
+                    sprintf(statusMessage, "BFS去重: %s", layeredBFS ? "分层批量" : "哈希表");
+                    needRedraw = true;
+                }
+                else if (key == 'p' || key == 'P') { // P键: 切换BFS/A*多线程并行
+                    parallelSearch = !parallelSearch;
+                    sprintf(statusMessage, "多线程搜索: %s", parallelSearch ? "开启" : "关闭");
+                    needRedraw = true;
+                }
+                else if (key == 'm' || key == 'M') { // M键: 切换超出内存预算时的处理
+                    memoryAction = memoryAction == MEMORY_COMPACT ? MEMORY_ABORT : memoryAction + 1;
+                    sprintf(statusMessage, "内存预算: %lld MB, 超出时: %s", memoryBudgetMB, GetMemoryActionName(memoryAction));
+                    needRedraw = true;
+                }
+                else if (key == 'g' || key == 'G') { // G键: 切换生成方式，下次生成场景时生效
+                    solvableGeneration = !solvableGeneration;
+                    sprintf(statusMessage, "生成场景: %s", solvableGeneration ? "随机打乱并验证有解" : "随机打乱");
+                    needRedraw = true;
+                }
+                else if (key == 'h' || key == 'H') { // H键: 切换A*启发函数
+                    currentHeuristic = (currentHeuristic + 1) % HEURISTIC_COUNT;
+                    sprintf(statusMessage, "A*启发函数: %s", GetHeuristicName(currentHeuristic));
+                    needRedraw = true;
+                }
             }
 
             if (needRedraw) {
@@ -2148,10 +1863,22 @@ int main() {
             }
         }
 
+        // 后台求解的进度与结果
+        if (pollBackgroundSolve()) {
+            drawCurrentState(solutionPath[currentStep]);
+            FlushBatchDraw();
+        }
+
         // 短暂延时
         Sleep(10);
     }
 
+    // 退出时取消仍在运行的求解
+    if (solverThread.joinable()) {
+        cancelSolve.store(true);
+        solverThread.join();
+    }
+
     EndBatchDraw();
     closegraph();
 
@@ -0,0 +1,83 @@
+﻿#pragma once
+// ==================== 死状态缓存 ====================
+// 记录已证明到不了目标的状态（去重键）。从状态 s 出发穷举可达状态，若在上限内穷尽且其中没有目标，
+// 则闭包里每个状态都到不了目标，整块记入缓存；搜索生成后继时查表，命中即剪掉。
+// 试管换位与颜色改名都不改变能否到达目标，因此可以直接用搜索的去重键穷举。
+// 缓存有容量上限，满后只查不插，内存不会随搜索无限增长。
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "PackedState.h"
+#include "MoveIterator.h"
+#include "StateTable.h"
+
+using namespace std;
+
+class DeadStateCache {
+public:
+    explicit DeadStateCache(size_t maxEntries) : maxStates(maxEntries) {}
+
+    bool contains(const PackedState& key) {
+        return table.size() > 0 && table.find(key) != NULL;
+    }
+
+    // 从 key 出发穷举可达状态，至多 limit 个；穷尽且没有目标时把闭包记入缓存并返回 true
+    bool probe(const PackedState& key, int initialEmptyTubes, bool tubeOrder, bool colorLabels, size_t limit) {
+        if (!ExhaustRegion(key, initialEmptyTubes, tubeOrder, colorLabels, limit, region)) return false;
+        for (size_t i = 0; i < region.size() && table.size() < maxStates; i++) {
+            bool inserted;
+            table.insertOrFind(region[i], 0, inserted);
+        }
+        return true;
+    }
+
+    size_t size() const { return table.size(); }
+    size_t memoryBytes() const { return table.stats().memoryBytes; }
+
+    // 穷举 key 的可达闭包（各状态取去重键），至多 limit 个状态。
+    // 穷尽且其中没有目标时返回 true，region 为整个闭包；超出上限或遇到目标时返回 false。
+    // 闭包小时线性查重，比建哈希表省；超过 LINEAR_REGION_STATES 个才改用哈希表。
+    static bool ExhaustRegion(const PackedState& key, int initialEmptyTubes, bool tubeOrder, bool colorLabels,
+        size_t limit, vector<PackedState>& region) {
+        region.clear();
+        region.push_back(key);
+        unique_ptr<StateTable<char> > seen;
+        for (size_t i = 0; i < region.size(); i++) {
+            PackedState state = region[i];
+            if (state.isGoal(initialEmptyTubes)) return false;
+
+            MoveIterator moves(state);
+            PourMove move;
+            while (moves.next(move)) {
+                PackedState child = state;
+                child.applyPour(move.from, move.to, move.amount);
+                PackedState childKey = child.symmetryReduced(tubeOrder, colorLabels);
+                if (seen) {
+                    bool inserted;
+                    seen->insertOrFind(childKey, 0, inserted);
+                    if (!inserted) continue;
+                }
+                else if (find(region.begin(), region.end(), childKey) != region.end()) {
+                    continue;
+                }
+                if (region.size() >= limit) return false;
+                region.push_back(childKey);
+                if (!seen && region.size() > LINEAR_REGION_STATES) {
+                    seen.reset(new StateTable<char>(limit));
+                    for (size_t j = 0; j < region.size(); j++) {
+                        bool inserted;
+                        seen->insertOrFind(region[j], 0, inserted);
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    static const size_t LINEAR_REGION_STATES = 128;
+
+    StateTable<char> table;
+    size_t maxStates;
+    vector<PackedState> region;     // 最近一次穷举的闭包，复用以免反复分配
+};
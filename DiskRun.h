@@ -0,0 +1,146 @@
+﻿#pragma once
+// ==================== 磁盘有序段 ====================
+// 外存 BFS 把每层状态写成临时文件中有序、无重复的段，只做顺序读写。
+// 同一关卡的试管数与容量固定，每条记录是状态的稠密编码（PackedState::encode，packedWords(n, m) 个字），
+// 段内按编码的字序排列（与 PackedState::operator< 相同），读回时解码并补上试管数与容量。
+// 读写都经过固定大小的缓冲区，缓冲区大小即该段占用的内存，由调用者按内存预算分配。
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "PackedState.h"
+
+using namespace std;
+
+class StateRunWriter {
+public:
+    StateRunWriter() : file(NULL), words(0), bufferRecords(0), buffered(0), written(0), error(false) {}
+    ~StateRunWriter() { close(); }
+
+    // recordWords 为每条记录的字数（packedWords(n, m)）
+    bool open(const string& path, int recordWords, size_t records) {
+        close();
+        words = recordWords;
+        bufferRecords = records > 0 ? records : 1;
+        buffer.assign(bufferRecords * words, 0);
+        buffered = 0;
+        written = 0;
+        file = fopen(path.c_str(), "wb");
+        error = file == NULL;
+        return !error;
+    }
+
+    void write(const PackedState& state) {
+        state.encode(&buffer[buffered * words]);
+        if (++buffered == bufferRecords) flush();
+        written++;
+    }
+
+    // 写入已编码的记录
+    void write(const uint64_t* record) {
+        memcpy(&buffer[buffered * words], record, words * sizeof(uint64_t));
+        if (++buffered == bufferRecords) flush();
+        written++;
+    }
+
+    // 写出剩余缓冲并关闭文件，返回全程是否成功
+    bool close() {
+        if (file != NULL) {
+            flush();
+            if (fclose(file) != 0) error = true;
+            file = NULL;
+        }
+        return !error;
+    }
+
+    size_t count() const { return written; }
+    size_t bufferBytes() const { return buffer.capacity() * sizeof(uint64_t); }
+
+private:
+    void flush() {
+        if (buffered > 0 && file != NULL && fwrite(&buffer[0], sizeof(uint64_t) * words, buffered, file) != buffered) {
+            error = true;
+        }
+        buffered = 0;
+    }
+
+    StateRunWriter(const StateRunWriter&);
+    StateRunWriter& operator=(const StateRunWriter&);
+
+    FILE* file;
+    int words;
+    size_t bufferRecords;
+    vector<uint64_t> buffer;
+    size_t buffered;
+    size_t written;
+    bool error;
+};
+
+class StateRunReader {
+public:
+    StateRunReader() : file(NULL), words(0), bufferRecords(0), position(0), filled(0), exhausted(true), error(false) {}
+    ~StateRunReader() { close(); }
+
+    // 打开后即读入第一条记录；文件为空时 valid() 为 false
+    bool open(const string& path, int tubes, int capacity, size_t records) {
+        close();
+        current.reset(tubes, capacity);
+        words = packedWords(tubes, capacity);
+        bufferRecords = records > 0 ? records : 1;
+        buffer.assign(bufferRecords * words, 0);
+        position = 0;
+        filled = 0;
+        exhausted = false;
+        file = fopen(path.c_str(), "rb");
+        error = file == NULL;
+        if (error) {
+            exhausted = true;
+            return false;
+        }
+        advance();
+        return true;
+    }
+
+    void close() {
+        if (file != NULL) fclose(file);
+        file = NULL;
+        exhausted = true;
+    }
+
+    bool valid() const { return !exhausted; }
+    bool failed() const { return error; }
+    const PackedState& state() const { return current; }
+    // 当前记录的稠密编码，下次 advance 前有效
+    const uint64_t* record() const { return &buffer[(position - 1) * words]; }
+    size_t bufferBytes() const { return buffer.capacity() * sizeof(uint64_t); }
+
+    // 读入下一条记录
+    void advance() {
+        if (position == filled) {
+            size_t recordBytes = sizeof(uint64_t) * words;
+            filled = file == NULL ? 0 : fread(&buffer[0], recordBytes, bufferRecords, file);
+            position = 0;
+            if (filled == 0) {
+                if (file != NULL && ferror(file)) error = true;
+                close();
+                return;
+            }
+        }
+        current.decode(&buffer[position * words], current.numTubes, current.capacity);
+        position++;
+    }
+
+private:
+    StateRunReader(const StateRunReader&);
+    StateRunReader& operator=(const StateRunReader&);
+
+    FILE* file;
+    int words;
+    size_t bufferRecords;
+    vector<uint64_t> buffer;
+    size_t position;
+    size_t filled;
+    PackedState current;
+    bool exhausted;
+    bool error;
+};
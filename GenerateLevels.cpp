@@ -0,0 +1,153 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+// ==================== 命令行关卡生成程序 ====================
+// 从目标状态随机反向倒水，批量生成保证有解的关卡，输出格式与批量求解程序的输入相同。
+// 同样的参数与种子总得到同样的关卡文件，与线程数无关；可随机打乱后求解验证，或指定最优步数范围控制难度。
+#include "LevelGenerator.h"
+#include "LevelCorpus.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+using namespace chrono;
+
+struct GenerateOptions {
+    GeneratorOptions generator;
+    int count;
+    int threads;
+    string outputPath;
+    string corpusPath;      // 二进制语料库输出文件
+
+    GenerateOptions() : count(100), threads(0) {}
+};
+
+// 每批生成的关卡数：分批写出，关卡很多时不必全部留在内存里
+const int GENERATE_CHUNK = 4096;
+
+static void printUsage(const char* prog) {
+    printf("用法: %s -n <试管数> -k <颜色数> -m <容量> [--count <数量>] [--seed <种子>] [-o <关卡文件>]\n", prog);
+    printf("  -n               试管数，默认 6\n");
+    printf("  -k               颜色数，须少于试管数，默认 4\n");
+    printf("  -m               试管容量，默认 4\n");
+    printf("  --count <数量>   生成的关卡数，默认 100\n");
+    printf("  --seed <种子>    随机数种子，默认 1；同一种子总生成同样的关卡\n");
+    printf("  --scramble <步数> 反向倒水的步数，默认 颜色数 x 容量 x 2\n");
+    printf("  --shuffle        随机打乱后用 A* 验证有解，难度与普通随机关卡相同（默认反向倒水，关卡偏简单）\n");
+    printf("  --min-steps <n>  最优步数下限（用 A* 求解判定），默认不限\n");
+    printf("  --max-steps <n>  最优步数上限，默认不限\n");
+    printf("  --attempts <n>   每个关卡最多重新生成的次数，默认 1000\n");
+    printf("  -j, --threads    生成线程数，默认使用全部核心\n");
+    printf("  -o, --output     关卡输出文件（默认标准输出）\n");
+    printf("  --corpus <文件>  同时写成二进制语料库；只给 --corpus 不给 -o 时不输出文本\n");
+}
+
+static bool parseArguments(int argc, char** argv, GenerateOptions& options) {
+    GeneratorOptions& generator = options.generator;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "-n" && hasValue) generator.numTubes = atoi(argv[++i]);
+        else if (arg == "-k" && hasValue) generator.numColors = atoi(argv[++i]);
+        else if (arg == "-m" && hasValue) generator.capacity = atoi(argv[++i]);
+        else if (arg == "--count" && hasValue) options.count = atoi(argv[++i]);
+        else if (arg == "--seed" && hasValue) generator.seed = strtoull(argv[++i], NULL, 10);
+        else if (arg == "--scramble" && hasValue) generator.scrambleMoves = max(0, atoi(argv[++i]));
+        else if (arg == "--shuffle") generator.shuffle = true;
+        else if (arg == "--min-steps" && hasValue) generator.minOptimal = max(0, atoi(argv[++i]));
+        else if (arg == "--max-steps" && hasValue) generator.maxOptimal = max(0, atoi(argv[++i]));
+        else if (arg == "--attempts" && hasValue) generator.maxAttempts = atoi(argv[++i]);
+        else if ((arg == "-j" || arg == "--threads") && hasValue) options.threads = atoi(argv[++i]);
+        else if ((arg == "-o" || arg == "--output") && hasValue) options.outputPath = argv[++i];
+        else if (arg == "--corpus" && hasValue) options.corpusPath = argv[++i];
+        else {
+            fprintf(stderr, "未知参数: %s\n", arg.c_str());
+            return false;
+        }
+    }
+    return options.count > 0;
+}
+
+int main(int argc, char** argv) {
+    GenerateOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const GeneratorOptions& generator = options.generator;
+    string problem = CheckGeneratorOptions(generator);
+    if (!problem.empty()) {
+        fprintf(stderr, "%s\n", problem.c_str());
+        return 1;
+    }
+
+    FILE* output = options.corpusPath.empty() ? stdout : NULL;
+    if (!options.outputPath.empty()) {
+        output = fopen(options.outputPath.c_str(), "w");
+        if (output == NULL) {
+            fprintf(stderr, "无法写入关卡文件: %s\n", options.outputPath.c_str());
+            return 1;
+        }
+    }
+    CorpusWriter corpus;
+    if (!options.corpusPath.empty() &&
+        !corpus.open(options.corpusPath, generator.numTubes, generator.numColors, generator.capacity, false)) {
+        fprintf(stderr, "无法写入语料库: %s\n", options.corpusPath.c_str());
+        return 1;
+    }
+    if (output != NULL) {
+        fprintf(output, "# 试管 %d, 颜色 %d, 容量 %d, 种子 %llu, 关卡数 %d\n",
+            generator.numTubes, generator.numColors, generator.capacity, generator.seed, options.count);
+        if (generator.minOptimal > 0 || generator.maxOptimal > 0) {
+            fprintf(output, "# 最优步数 %d ~ %s\n", generator.minOptimal,
+                generator.maxOptimal > 0 ? to_string(generator.maxOptimal).c_str() : "不限");
+        }
+    }
+
+    auto startTime = steady_clock::now();
+    int written = 0;
+    int failed = 0;
+    long long attempts = 0;
+    int shortest = -1;
+    int longest = -1;
+    vector<GeneratedLevel> levels;
+    for (int first = 0; first < options.count; first += GENERATE_CHUNK) {
+        int chunk = min(GENERATE_CHUNK, options.count - first);
+        GenerateSolvableLevels(generator, (unsigned long long)first, chunk, options.threads, levels);
+        for (int i = 0; i < chunk; i++) {
+            attempts += levels[i].attempts;
+            if (!levels[i].ok) {
+                failed++;
+                continue;
+            }
+            if (output != NULL) fprintf(output, "%s\n", FormatLevelLine(levels[i].level).c_str());
+            PackedState packed;
+            if (corpus.isOpen() && packState(levels[i].level, packed)) corpus.append(packed);
+            written++;
+            int length = levels[i].optimalLength;
+            if (length >= 0) {
+                shortest = shortest < 0 ? length : min(shortest, length);
+                longest = max(longest, length);
+            }
+        }
+    }
+    if (output != NULL && output != stdout) fclose(output);
+    if (corpus.isOpen() && !corpus.close()) {
+        fprintf(stderr, "写入语料库失败: %s\n", options.corpusPath.c_str());
+        return 1;
+    }
+
+    long long totalTime = duration_cast<milliseconds>(steady_clock::now() - startTime).count();
+    double perSecond = totalTime > 0 ? written * 1000.0 / totalTime : 0.0;
+    fprintf(stderr, "生成 %d 个关卡, 平均尝试 %.2f 次, 耗时 %lld ms (%.0f 个/秒)\n",
+        written, options.count > 0 ? (double)attempts / options.count : 0.0, totalTime, perSecond);
+    if (shortest >= 0) {
+        fprintf(stderr, "最优步数 %d ~ %d\n", shortest, longest);
+    }
+    if (failed > 0) {
+        fprintf(stderr, "%d 个关卡在 %d 次尝试内未落在步数范围内，已跳过\n", failed, generator.maxAttempts);
+    }
+    return failed > 0 ? 2 : 0;
+}
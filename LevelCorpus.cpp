@@ -0,0 +1,334 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+#include "LevelCorpus.h"
+#include <string.h>
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+static const char CORPUS_MAGIC[8] = { 'W', 'S', 'C', 'O', 'R', 'P', 'U', 'S' };
+static const size_t CORPUS_BUFFER_BYTES = 1 << 20;  // 写入缓冲，满了才调用 fwrite
+
+static void putU16(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static void putU64(uint8_t* out, uint64_t value) {
+    for (int i = 0; i < 8; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint16_t getU16(const uint8_t* in) {
+    return (uint16_t)(in[0] | (in[1] << 8));
+}
+
+static uint64_t getU64(const uint8_t* in) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) value = (value << 8) | in[i];
+    return value;
+}
+
+static size_t packedLevelBytes(int numTubes, int capacity) {
+    return ((size_t)numTubes * capacity + 1) / 2;
+}
+
+bool IsCorpusFile(const string& path) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == NULL) return false;
+    char magic[sizeof(CORPUS_MAGIC)];
+    bool match = fread(magic, 1, sizeof(magic), file) == sizeof(magic) && memcmp(magic, CORPUS_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return match;
+}
+
+// ==================== 写入 ====================
+
+CorpusWriter::CorpusWriter() : file(NULL), tubes(0), colors(0), cells(0), solutions(false), levelBytes(0),
+    position(0), written(0), error(false) {}
+
+bool CorpusWriter::open(const string& path, int numTubes, int numColors, int capacity, bool withSolutions) {
+    close();
+    if (numTubes < 1 || numTubes > PACKED_MAX_TUBES || numColors < 1 || numColors > PACKED_MAX_COLOR ||
+        capacity < 1 || capacity > PACKED_MAX_CAPACITY) {
+        return false;
+    }
+    tubes = numTubes;
+    colors = numColors;
+    cells = capacity;
+    solutions = withSolutions;
+    levelBytes = packedLevelBytes(numTubes, capacity);
+    buffer.clear();
+    buffer.reserve(CORPUS_BUFFER_BYTES);
+    offsets.clear();
+    written = 0;
+    file = fopen(path.c_str(), "wb");
+    error = file == NULL;
+    if (error) return false;
+
+    // 先写关卡数为 0 的文件头占位，close() 时回填
+    position = CORPUS_HEADER_BYTES;
+    writeHeader(0);
+    return !error;
+}
+
+bool CorpusWriter::append(const PackedState& level) {
+    return appendRecord(level, NULL);
+}
+
+bool CorpusWriter::append(const PackedState& level, const vector<CorpusMove>& solution) {
+    return appendRecord(level, &solution);
+}
+
+bool CorpusWriter::appendRecord(const PackedState& level, const vector<CorpusMove>* solution) {
+    if (file == NULL || level.numTubes != tubes || level.capacity != cells) return false;
+    for (int t = 0; t < tubes; t++) {
+        for (int j = 0; j < cells; j++) {
+            if (level.colorAt(t, j) > colors) return false;
+        }
+    }
+    if (solutions && solution != NULL) {
+        if (solution->size() >= CORPUS_NO_SOLUTION) return false;
+        for (size_t i = 0; i < solution->size(); i++) {
+            if ((*solution)[i].from >= tubes || (*solution)[i].to >= tubes) return false;
+        }
+    }
+
+    size_t start = buffer.size();
+    buffer.resize(start + levelBytes, 0);
+    for (int t = 0; t < tubes; t++) {
+        for (int j = 0; j < cells; j++) {
+            size_t cell = (size_t)t * cells + j;
+            buffer[start + cell / 2] |= (uint8_t)(level.colorAt(t, j) << (4 * (cell & 1)));
+        }
+    }
+    if (solutions) {
+        // 无解法的语料库忽略 solution
+        offsets.push_back(position);
+        size_t moveCount = solution != NULL ? solution->size() : 0;
+        size_t head = buffer.size();
+        buffer.resize(head + 2 + 2 * moveCount);
+        putU16(&buffer[head], solution != NULL ? (uint16_t)moveCount : CORPUS_NO_SOLUTION);
+        for (size_t i = 0; i < moveCount; i++) {
+            buffer[head + 2 + 2 * i] = (*solution)[i].from;
+            buffer[head + 3 + 2 * i] = (*solution)[i].to;
+        }
+    }
+    position += buffer.size() - start;
+    written++;
+    if (buffer.size() >= CORPUS_BUFFER_BYTES) flush();
+    return true;
+}
+
+bool CorpusWriter::close() {
+    if (file == NULL) return !error;
+
+    uint64_t indexOffset = 0;
+    if (solutions) {
+        flush();
+        indexOffset = position;
+        for (size_t i = 0; i < offsets.size(); i++) {
+            buffer.resize(buffer.size() + 8);
+            putU64(&buffer[buffer.size() - 8], offsets[i]);
+            if (buffer.size() >= CORPUS_BUFFER_BYTES) flush();
+        }
+    }
+    flush();
+
+    // 回填关卡数与偏移表位置
+    if (fseek(file, 0, SEEK_SET) != 0) error = true;
+    else writeHeader(indexOffset);
+    if (fclose(file) != 0) error = true;
+    file = NULL;
+    offsets.clear();
+    offsets.shrink_to_fit();
+    return !error;
+}
+
+void CorpusWriter::writeHeader(uint64_t indexOffset) {
+    uint8_t header[CORPUS_HEADER_BYTES];
+    memset(header, 0, sizeof(header));
+    memcpy(header, CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+    putU16(header + 8, CORPUS_VERSION);
+    header[10] = (uint8_t)tubes;
+    header[11] = (uint8_t)colors;
+    header[12] = (uint8_t)cells;
+    header[13] = (uint8_t)(solutions ? CORPUS_HAS_SOLUTIONS : 0);
+    putU64(header + 16, written);
+    putU64(header + 24, indexOffset);
+    if (fwrite(header, 1, sizeof(header), file) != sizeof(header)) error = true;
+}
+
+void CorpusWriter::flush() {
+    if (!buffer.empty() && file != NULL && fwrite(&buffer[0], 1, buffer.size(), file) != buffer.size()) {
+        error = true;
+    }
+    buffer.clear();
+}
+
+// ==================== 读取 ====================
+
+CorpusReader::CorpusReader() : data(NULL), bytes(0), levelCount(0), tubes(0), colors(0), cells(0), solutions(false),
+    recordLevelBytes(0), indexOffset(0) {}
+
+bool CorpusReader::open(const string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        problem = "无法打开文件";
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || (unsigned long long)fileSize.QuadPart < CORPUS_HEADER_BYTES ||
+        (unsigned long long)fileSize.QuadPart > (size_t)-1) {
+        CloseHandle(file);
+        problem = "文件过小或过大";
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    void* view = mapping != NULL ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+    // 映射视图建立后不再需要文件与映射句柄
+    if (mapping != NULL) CloseHandle(mapping);
+    CloseHandle(file);
+    if (view == NULL) {
+        problem = "无法映射文件";
+        return false;
+    }
+    bytes = (size_t)fileSize.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        problem = "无法打开文件";
+        return false;
+    }
+    struct stat info;
+    if (fstat(file, &info) != 0 || (unsigned long long)info.st_size < CORPUS_HEADER_BYTES ||
+        (unsigned long long)info.st_size > (size_t)-1) {
+        ::close(file);
+        problem = "文件过小或过大";
+        return false;
+    }
+    void* view = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    // 映射建立后不再需要文件描述符
+    ::close(file);
+    if (view == MAP_FAILED) {
+        problem = "无法映射文件";
+        return false;
+    }
+    bytes = (size_t)info.st_size;
+#endif
+    data = (const uint8_t*)view;
+
+    if (memcmp(data, CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) != 0) {
+        close();
+        problem = "不是关卡语料库文件";
+        return false;
+    }
+    if (getU16(data + 8) != CORPUS_VERSION) {
+        close();
+        problem = "不支持的版本 " + to_string(getU16(data + 8));
+        return false;
+    }
+    tubes = data[10];
+    colors = data[11];
+    cells = data[12];
+    solutions = (data[13] & CORPUS_HAS_SOLUTIONS) != 0;
+    if (tubes < 1 || tubes > PACKED_MAX_TUBES || colors < 1 || colors > PACKED_MAX_COLOR ||
+        cells < 1 || cells > PACKED_MAX_CAPACITY) {
+        close();
+        problem = "文件头中的试管数、颜色数或容量超出范围";
+        return false;
+    }
+    recordLevelBytes = packedLevelBytes(tubes, cells);
+    uint64_t count = getU64(data + 16);
+    indexOffset = getU64(data + 24);
+    bool fits;
+    if (solutions && count == 0 && indexOffset == 0) {
+        fits = true;    // 写入中断：文件头仍是占位值，按空语料库读取
+    }
+    else if (solutions) {
+        fits = indexOffset >= CORPUS_HEADER_BYTES && indexOffset <= bytes && count <= (bytes - indexOffset) / 8;
+    }
+    else {
+        fits = count <= (bytes - CORPUS_HEADER_BYTES) / recordLevelBytes;
+    }
+    if (!fits) {
+        close();
+        problem = "文件不完整";
+        return false;
+    }
+    levelCount = (size_t)count;
+    problem.clear();
+    return true;
+}
+
+void CorpusReader::close() {
+    if (data != NULL) {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap((void*)data, bytes);
+#endif
+    }
+    data = NULL;
+    bytes = 0;
+    levelCount = 0;
+}
+
+// 第 i 条记录的起点；available 为记录区内从起点到末尾的字节数，用来校验偏移表中的偏移
+const uint8_t* CorpusReader::recordAt(size_t i, size_t& available) const {
+    if (i >= levelCount) return NULL;
+    uint64_t offset;
+    uint64_t end;
+    if (solutions) {
+        offset = getU64(data + indexOffset + 8 * i);
+        end = indexOffset;
+    }
+    else {
+        offset = CORPUS_HEADER_BYTES + (uint64_t)i * recordLevelBytes;
+        end = bytes;
+    }
+    if (offset < CORPUS_HEADER_BYTES || offset >= end) return NULL;
+    available = (size_t)(end - offset);
+    return data + offset;
+}
+
+const uint8_t* CorpusReader::levelBytes(size_t i) const {
+    size_t available;
+    const uint8_t* record = recordAt(i, available);
+    return record != NULL && available >= recordLevelBytes ? record : NULL;
+}
+
+bool CorpusReader::level(size_t i, PackedState& out) const {
+    const uint8_t* record = levelBytes(i);
+    if (record == NULL) return false;
+    out.reset(tubes, cells);
+    for (int t = 0; t < tubes; t++) {
+        uint64_t word = 0;
+        for (int j = cells - 1; j >= 0; j--) {
+            size_t cell = (size_t)t * cells + j;
+            word = (word << 4) | ((record[cell / 2] >> (4 * (cell & 1))) & 0xF);
+        }
+        out.tubes[t] = word;
+    }
+    return true;
+}
+
+int CorpusReader::solution(size_t i, const uint8_t*& moves) const {
+    moves = NULL;
+    if (!solutions) return -1;
+    size_t available;
+    const uint8_t* record = recordAt(i, available);
+    if (record == NULL || available < recordLevelBytes + 2) return -1;
+    uint16_t count = getU16(record + recordLevelBytes);
+    if (count == CORPUS_NO_SOLUTION || available < recordLevelBytes + 2 + 2 * (size_t)count) return -1;
+    moves = record + recordLevelBytes + 2;
+    return count;
+}
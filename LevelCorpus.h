@@ -0,0 +1,124 @@
+﻿#pragma once
+// ==================== 关卡语料库二进制格式 ====================
+// 大量关卡（及可选的解）存成一个二进制文件：写入时流式追加，读取时整个文件内存映射，
+// 不解析文本、不整体读入，按下标随机访问，关卡与解法字节直接指向映射内存。
+//
+// 文件布局（多字节整数均为小端序）：
+//   文件头 CORPUS_HEADER_BYTES 字节
+//     0   char[8]  "WSCORPUS"
+//     8   uint16   版本号 CORPUS_VERSION
+//     10  uint8    试管数 n        11  uint8  颜色数 k        12  uint8  容量 m
+//     13  uint8    标志位（CORPUS_HAS_SOLUTIONS）
+//     14  uint16   保留，为 0
+//     16  uint64   关卡数（写完后回填，写入中断的文件读出 0 个关卡）
+//     24  uint64   偏移表的文件偏移，无解法或写入中断时为 0
+//   关卡记录，依次紧接文件头
+//     关卡   n 个试管各 m 格、每格 4 位颜色（0 为空），按试管、自底向上排列，低半字节在前，共 (n*m+1)/2 字节
+//     解法   仅有解法时：uint16 步数（CORPUS_NO_SOLUTION 表示未记录解），再跟每步 2 字节：倒出、倒入试管下标（从0开始）
+//   偏移表   仅有解法时：每个关卡一个 uint64，为其记录的文件偏移
+// 无解法时记录定长，第 i 个关卡位于 文件头 + i * 关卡字节数 处，不需要偏移表。
+// 每一步只记两个试管下标，倒水量由规则决定，重放即可得到各步状态。
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "PackedState.h"
+
+using namespace std;
+
+const int CORPUS_VERSION = 1;
+const size_t CORPUS_HEADER_BYTES = 32;
+const int CORPUS_HAS_SOLUTIONS = 1;
+const uint16_t CORPUS_NO_SOLUTION = 0xFFFF;
+
+struct CorpusMove {
+    uint8_t from;
+    uint8_t to;
+};
+
+// 判断文件是否为语料库（检查文件头标识）
+bool IsCorpusFile(const string& path);
+
+class CorpusWriter {
+public:
+    CorpusWriter();
+    ~CorpusWriter() { close(); }
+
+    // 所有关卡的试管数、颜色数、容量相同；withSolutions 为 true 时每个关卡带一个解（可为未记录）
+    bool open(const string& path, int numTubes, int numColors, int capacity, bool withSolutions);
+
+    // 追加一个关卡。试管数、容量与文件头不符或颜色超过颜色数时不写入并返回 false
+    bool append(const PackedState& level);
+    bool append(const PackedState& level, const vector<CorpusMove>& solution);
+
+    // 写出剩余缓冲与偏移表、回填文件头并关闭，返回全程是否成功
+    bool close();
+
+    bool isOpen() const { return file != NULL; }
+    size_t count() const { return written; }
+    int numTubes() const { return tubes; }
+    int capacity() const { return cells; }
+
+private:
+    bool appendRecord(const PackedState& level, const vector<CorpusMove>* solution);
+    void flush();
+    void writeHeader(uint64_t indexOffset);   // 在文件当前位置写文件头
+
+    CorpusWriter(const CorpusWriter&);
+    CorpusWriter& operator=(const CorpusWriter&);
+
+    FILE* file;
+    int tubes;
+    int colors;
+    int cells;
+    bool solutions;
+    size_t levelBytes;
+    vector<uint8_t> buffer;
+    vector<uint64_t> offsets;   // 各记录的文件偏移，仅有解法时需要
+    uint64_t position;          // 下一条记录的文件偏移
+    size_t written;
+    bool error;
+};
+
+class CorpusReader {
+public:
+    CorpusReader();
+    ~CorpusReader() { close(); }
+
+    // 映射整个文件并校验文件头与偏移表范围，失败时返回 false，原因见 error()
+    bool open(const string& path);
+    void close();
+
+    size_t size() const { return levelCount; }
+    int numTubes() const { return tubes; }
+    int numColors() const { return colors; }
+    int capacity() const { return cells; }
+    bool hasSolutions() const { return solutions; }
+    const string& error() const { return problem; }
+
+    // 第 i 个关卡的原始字节（指向映射内存，共 (n*m+1)/2 字节），记录越界时返回 NULL
+    const uint8_t* levelBytes(size_t i) const;
+
+    // 解码第 i 个关卡
+    bool level(size_t i, PackedState& out) const;
+
+    // 第 i 个关卡的解的步数，moves 指向映射内存中的 2*步数 字节；没有或未记录解时返回 -1
+    int solution(size_t i, const uint8_t*& moves) const;
+
+private:
+    const uint8_t* recordAt(size_t i, size_t& available) const;
+
+    CorpusReader(const CorpusReader&);
+    CorpusReader& operator=(const CorpusReader&);
+
+    const uint8_t* data;    // 映射的整个文件；映射建立后文件句柄即可关闭
+    size_t bytes;
+    size_t levelCount;
+    int tubes;
+    int colors;
+    int cells;
+    bool solutions;
+    size_t recordLevelBytes;
+    uint64_t indexOffset;
+    string problem;
+};
@@ -0,0 +1,252 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+#include "LevelGenerator.h"
+#include <stdint.h>
+#include <random>
+#include <thread>
+#include <atomic>
+
+using namespace std;
+
+// 每次尝试最多走 scrambleMoves 的这么多倍步（含退回的步）
+const int SCRAMBLE_TRIES = 4;
+// 连续 (试管数 + 容量) 的这么多倍步没遇到装满状态就退回；须长于从目标状态首次走到装满状态的步数
+const int SCRAMBLE_WINDOW = 2;
+// 求最优步数时 A* 的内存预算；随机打乱的关卡可能无解，超出预算即视为这次尝试失败
+const long long GENERATOR_SOLVE_BYTES = 64LL * 1024 * 1024;
+
+// 反向倒水：从 from 顶部取 amount 格放回 to，得到的状态经正向倒水 to→from 恰好回到原状态
+struct ReverseMove {
+    int from;
+    int to;
+    int amount;
+};
+
+static uint64_t splitMix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 第 index 个关卡第 attempt 次尝试的随机数流种子
+static uint64_t streamSeed(unsigned long long seed, unsigned long long index, int attempt) {
+    return splitMix64(splitMix64(splitMix64(seed) ^ index) ^ (uint64_t)attempt);
+}
+
+static PackedState reversePour(const PackedState& state, const ReverseMove& move) {
+    PackedState before = state;
+    int color = state.topColor(move.from);
+    before.tubes[move.from] &= nibbleMask(state.tubeSize(move.from) - move.amount);
+    for (int i = 0; i < move.amount; i++) before.push(move.to, color);
+    return before;
+}
+
+// 列出所有合法的反向倒水。从 from 顶段（颜色 c，长 segment）取 amount 格放到 to 上，正向倒回须满足：
+//   取完后 from 为空或顶部仍是 c，即 amount == size 或 amount < segment；
+//   倒水量恰为 amount：to 原顶部不是 c 时 to 顶段正好 amount 格，是 c 时只能靠 from 原本装满来截断。
+static void listReverseMoves(const PackedState& state, vector<ReverseMove>& moves) {
+    int sizes[PACKED_MAX_TUBES];
+    int tops[PACKED_MAX_TUBES];
+    for (int i = 0; i < state.numTubes; i++) {
+        sizes[i] = state.tubeSize(i);
+        tops[i] = sizes[i] == 0 ? -1 : state.colorAt(i, sizes[i] - 1);
+    }
+    moves.clear();
+    for (int from = 0; from < state.numTubes; from++) {
+        if (sizes[from] == 0) continue;
+        int segment = state.topSegmentSize(from);
+        // amount == segment 只在整管倒出时合法
+        int longest = segment < sizes[from] ? segment - 1 : segment;
+        for (int to = 0; to < state.numTubes; to++) {
+            if (to == from) continue;
+            if (tops[to] == tops[from] && sizes[from] < state.capacity) continue;
+            int most = min(longest, state.capacity - sizes[to]);
+            for (int amount = 1; amount <= most; amount++) {
+                ReverseMove move = { from, to, amount };
+                moves.push_back(move);
+            }
+        }
+    }
+}
+
+// 非空试管的空位总数：为 0 时所有非空试管都装满，空试管数正好与目标状态相同
+static int unfilledSpace(const PackedState& state) {
+    int space = 0;
+    for (int i = 0; i < state.numTubes; i++) {
+        if (!state.isEmpty(i)) space += state.freeSpace(i);
+    }
+    return space;
+}
+
+// 从目标状态随机反向倒水，走满 scrambleMoves 步（含退回后重走的步）后停在第一个非空试管全部装满的非目标状态上（空试管数与目标相同）。
+// 随机游走常会陷进很难再回到装满状态的区域：连续若干步没遇到装满状态，就退回最近一次的装满状态
+// （还没有则退回目标状态）另走。有些状态没有任何合法的反向倒水，走到这里就退回上一步另选。
+static bool scramble(const GeneratorOptions& options, mt19937_64& random, PackedState& state) {
+    int n = options.numTubes;
+    int k = options.numColors;
+    int m = options.capacity;
+    int steps = options.scrambleMoves > 0 ? options.scrambleMoves : k * m * 2;
+    int window = SCRAMBLE_WINDOW * (n + m);
+
+    state.reset(n, m);
+    for (int c = 0; c < k; c++) {
+        for (int j = 0; j < m; j++) state.push(c, c + 1);
+    }
+
+    vector<PackedState> path(1, state);
+    vector<size_t> filled(1, 0);    // 路径上各装满状态的下标
+    int sinceFilled = 0;
+    vector<ReverseMove> moves;
+    ReverseMove last = { -1, -1, 0 };
+    for (int walked = 0; walked < steps * SCRAMBLE_TRIES; walked++) {
+        if (++sinceFilled > window) {
+            path.resize(filled.back() + 1);
+            sinceFilled = 0;
+            last.from = -1;
+        }
+        listReverseMoves(path.back(), moves);
+        if (moves.empty()) {
+            if (path.size() > 1) path.pop_back();
+            if (filled.back() >= path.size()) filled.pop_back();
+            last.from = -1;
+            continue;
+        }
+        // 不立即撤销上一步，除非别无选择
+        size_t choices = moves.size();
+        size_t pick = (size_t)(random() % choices);
+        if (choices > 1 && moves[pick].from == last.to && moves[pick].to == last.from && moves[pick].amount == last.amount) {
+            pick = (pick + 1 + (size_t)(random() % (choices - 1))) % choices;
+        }
+        last = moves[pick];
+        path.push_back(reversePour(path.back(), last));
+
+        const PackedState& current = path.back();
+        if (unfilledSpace(current) == 0) {
+            if (walked >= steps && !current.isGoal(n - k)) {
+                state = current;
+                return true;
+            }
+            filled.push_back(path.size() - 1);
+            sinceFilled = 0;
+        }
+    }
+    return false;
+}
+
+// 把 numColors * capacity 格颜色随机打乱装进前 numColors 个试管，其余试管留空，与图形界面随机打乱生成场景相同。
+// 用随机数流自己洗牌（而不是 std::shuffle），保证各平台上同样的种子得到同样的关卡
+static void shuffleLevel(const GeneratorOptions& options, mt19937_64& random, PackedState& state) {
+    vector<int> pool;
+    for (int c = 1; c <= options.numColors; c++) {
+        for (int j = 0; j < options.capacity; j++) pool.push_back(c);
+    }
+    for (size_t i = pool.size() - 1; i > 0; i--) {
+        swap(pool[i], pool[(size_t)(random() % (i + 1))]);
+    }
+    state.reset(options.numTubes, options.capacity);
+    for (size_t i = 0; i < pool.size(); i++) state.push((int)(i / options.capacity), pool[i]);
+}
+
+// 用 A* 求最优步数，无解或超出内存预算时返回 -1
+static int solveOptimal(const GeneratorOptions& options, const GameState& level) {
+    SolverContext ctx;
+    ctx.initialEmptyTubes = options.numTubes - options.numColors;
+    ctx.memoryBudgetBytes = GENERATOR_SOLVE_BYTES;
+    if (!SolveWithAlgorithm("A*", level, ctx)) return -1;
+    return (int)ctx.solutionPath.size() - 1;
+}
+
+string CheckGeneratorOptions(const GeneratorOptions& options) {
+    if (options.numColors < 1 || options.numColors > PACKED_MAX_COLOR) return "颜色数须在 1~15 之间";
+    if (options.numTubes <= options.numColors) return "试管数须多于颜色数（目标状态至少要有一个空试管）";
+    if (options.numTubes > PACKED_MAX_TUBES) return "试管数不能超过16";
+    if (options.capacity < 1 || options.capacity > PACKED_MAX_CAPACITY) return "容量须在 1~16 之间";
+    if (options.maxOptimal > 0 && options.minOptimal > options.maxOptimal) return "最优步数下限大于上限";
+    if (options.maxAttempts < 1) return "尝试次数至少为1";
+    return "";
+}
+
+GeneratedLevel GenerateSolvableLevel(const GeneratorOptions& options, unsigned long long index) {
+    GeneratedLevel result;
+    result.optimalLength = -1;
+    result.ok = false;
+    bool rangeLimited = options.minOptimal > 0 || options.maxOptimal > 0;
+    bool shuffled = options.shuffle;
+
+    for (result.attempts = 1; result.attempts <= options.maxAttempts; result.attempts++) {
+        mt19937_64 random(streamSeed(options.seed, index, result.attempts - 1));
+        PackedState state;
+        if (shuffled) shuffleLevel(options, random, state);
+        else if (!scramble(options, random, state)) continue;
+
+        // 空试管排到最后，与随机打乱生成的关卡外观一致；试管换位不影响可解性与步数
+        PackedState ordered;
+        ordered.reset(state.numTubes, state.capacity);
+        int next = 0;
+        for (int i = 0; i < state.numTubes; i++) {
+            if (!state.isEmpty(i)) ordered.tubes[next++] = state.tubes[i];
+        }
+        result.level = unpackState(ordered);
+        result.level.operation = "初始状态";
+        result.level.hCost = result.level.calculateHeuristic();
+        if (!rangeLimited && !shuffled) {
+            result.ok = true;
+            return result;
+        }
+
+        // 随机打乱的关卡可能无解或已是目标状态，求解失败就换下一个随机数流
+        result.optimalLength = solveOptimal(options, result.level);
+        if (result.optimalLength <= 0) continue;
+        if (result.optimalLength >= options.minOptimal &&
+            (options.maxOptimal <= 0 || result.optimalLength <= options.maxOptimal)) {
+            result.ok = true;
+            return result;
+        }
+        // 反向倒水得到的关卡比随机打乱的简单：低于下限就改用随机打乱，打乱的高于上限再改回反向倒水
+        if (!shuffled && result.optimalLength < options.minOptimal) shuffled = true;
+        else if (shuffled && options.maxOptimal > 0 && result.optimalLength > options.maxOptimal) shuffled = options.shuffle;
+    }
+    result.optimalLength = -1;
+    result.attempts = options.maxAttempts;
+    return result;
+}
+
+void GenerateSolvableLevels(const GeneratorOptions& options, unsigned long long firstIndex, int count, int threads,
+    vector<GeneratedLevel>& levels) {
+    levels.assign(count, GeneratedLevel());
+    int threadCount = threads > 0 ? threads : (int)thread::hardware_concurrency();
+    threadCount = max(1, min(threadCount, count));
+
+    atomic<int> nextLevel(0);
+    auto worker = [&]() {
+        while (true) {
+            int i = nextLevel.fetch_add(1);
+            if (i >= count) break;
+            levels[i] = GenerateSolvableLevel(options, firstIndex + i);
+        }
+    };
+    vector<thread> workers;
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(thread(worker));
+    }
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+string FormatLevelLine(const GameState& level) {
+    string line = to_string(level.tubes.empty() ? 0 : level.tubes[0].capacity);
+    for (size_t i = 0; i < level.tubes.size(); i++) {
+        const vector<int>& colors = level.tubes[i].colors;
+        line += ' ';
+        if (colors.empty()) {
+            line += '-';
+            continue;
+        }
+        for (size_t j = 0; j < colors.size(); j++) {
+            if (j > 0) line += ',';
+            line += to_string(colors[j]);
+        }
+    }
+    return line;
+}
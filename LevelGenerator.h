@@ -0,0 +1,49 @@
+﻿#pragma once
+// ==================== 保证有解的关卡生成 ====================
+// 从目标状态（numColors 个装满的单色试管加若干空试管）出发，随机做合法的反向倒水：
+// 每一步都能被一次正向倒水撤销，因此生成的关卡必然有解，无需求解后再筛掉无解关卡。
+// 第 index 个关卡只由 (seed, index) 决定，与线程数和生成顺序无关，同样的参数总得到同样的关卡集。
+// 反向倒水只能回到离目标较近的装满状态，得到的关卡比随机打乱的明显简单（步数范围见 README）。
+// 要与随机打乱同等难度时改用 shuffle：随机打乱后用 A* 求解，无解就换下一个随机数流，同样保证输出的关卡有解。
+// 指定最优步数范围时，用 A* 求出最优步数，不在范围内就换下一个随机数流重新生成；
+// 反向倒水的结果低于下限时自动改用随机打乱，因此范围可以覆盖随机打乱关卡的常见步数。
+#include <string>
+#include <vector>
+#include "SolverCore.h"
+
+using namespace std;
+
+struct GeneratorOptions {
+    int numTubes;               // 试管数 n，须多于颜色数（目标状态至少要有一个空试管才能反向倒水）
+    int numColors;              // 颜色数 k，每种颜色 capacity 格
+    int capacity;               // 试管容量 m
+    unsigned long long seed;
+    int scrambleMoves;          // 反向倒水的步数，0 表示 numColors * capacity * 2
+    int minOptimal;             // 最优步数下限，0 表示不限
+    int maxOptimal;             // 最优步数上限，0 表示不限
+    int maxAttempts;            // 每个关卡最多尝试的随机数流个数
+    bool shuffle;               // 随机打乱后求解验证，而不是反向倒水
+
+    GeneratorOptions() : numTubes(6), numColors(4), capacity(4), seed(1), scrambleMoves(0),
+        minOptimal(0), maxOptimal(0), maxAttempts(1000), shuffle(false) {}
+};
+
+struct GeneratedLevel {
+    GameState level;
+    int optimalLength;          // 最优步数，反向倒水且未限定范围时不求解，为 -1
+    int attempts;               // 用掉的随机数流个数
+    bool ok;                    // false 表示 maxAttempts 次都没有落在范围内
+};
+
+// 参数不合法时返回原因，否则返回空串
+string CheckGeneratorOptions(const GeneratorOptions& options);
+
+// 生成第 index 个关卡
+GeneratedLevel GenerateSolvableLevel(const GeneratorOptions& options, unsigned long long index);
+
+// 多线程生成 count 个关卡（threads 为 0 表示全部核心），结果按下标 firstIndex 起依次排列
+void GenerateSolvableLevels(const GeneratorOptions& options, unsigned long long firstIndex, int count, int threads,
+    vector<GeneratedLevel>& levels);
+
+// 关卡的文本形式，与批量求解程序的输入格式相同，如 "4 1,2,1,2 2,1,2,1 - -"
+string FormatLevelLine(const GameState& level);
@@ -0,0 +1,55 @@
+﻿#pragma once
+// ==================== 惰性后继生成 ====================
+// 按 (源试管, 目标试管) 顺序逐个产生移动，不复制状态、不分配内存。
+// 构造时一次性缓存各试管的高度、顶色和顶段长度，之后每个试管对只需常数次比较。
+// 只产生合法移动：目标试管已满或顶色不同的试管对直接跳过。
+#include "PackedState.h"
+
+struct PourMove {
+    int from;
+    int to;
+    int amount;             // 倒水量
+    int color;              // 倒出的颜色
+};
+
+class MoveIterator {
+public:
+    explicit MoveIterator(const PackedState& state)
+        : numTubes(state.numTubes), capacity(state.capacity), from(0), to(-1) {
+        for (int i = 0; i < numTubes; i++) {
+            sizes[i] = state.tubeSize(i);
+            topColors[i] = sizes[i] == 0 ? -1 : state.colorAt(i, sizes[i] - 1);
+            segments[i] = state.topSegmentSize(i);
+        }
+    }
+
+    // 取下一个移动，没有更多移动时返回 false
+    bool next(PourMove& move) {
+        while (from < numTubes) {
+            if (sizes[from] == 0 || ++to >= numTubes) {
+                from++;
+                to = -1;
+                continue;
+            }
+            if (to == from || sizes[to] >= capacity) continue;
+            if (sizes[to] != 0 && topColors[to] != topColors[from]) continue;
+
+            int space = capacity - sizes[to];
+            move.from = from;
+            move.to = to;
+            move.color = topColors[from];
+            move.amount = segments[from] < space ? segments[from] : space;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    int numTubes;
+    int capacity;
+    int from;
+    int to;
+    int sizes[PACKED_MAX_TUBES];
+    int topColors[PACKED_MAX_TUBES];
+    int segments[PACKED_MAX_TUBES];
+};
@@ -0,0 +1,62 @@
+﻿#pragma once
+// ==================== 搜索节点内存池 ====================
+// 按块连续分配搜索节点，单个节点不单独释放；
+// 池对象析构或调用 release() 时一次性归还所有块。
+// 每次求解在函数内持有一个池，求解结束（包括提前返回）即整体释放。
+#include <vector>
+#include <new>
+#include <stddef.h>
+#include <type_traits>
+
+using namespace std;
+
+template <typename T>
+class NodeArena {
+    static_assert(is_trivially_destructible<T>::value, "NodeArena 不调用析构函数，节点类型必须可平凡析构");
+
+public:
+    explicit NodeArena(size_t nodesPerBlock = 4096)
+        : blockSize(nodesPerBlock > 0 ? nodesPerBlock : 1), used(0), nodeCount(0) {}
+
+    ~NodeArena() { release(); }
+
+    // 分配一个值初始化的节点
+    T* allocate() {
+        if (blocks.empty() || used == blockSize) {
+            blocks.push_back(static_cast<T*>(::operator new(blockSize * sizeof(T))));
+            used = 0;
+        }
+        T* node = new (blocks.back() + used) T();
+        used++;
+        nodeCount++;
+        return node;
+    }
+
+    // 一次性释放所有节点
+    void release() {
+        for (size_t i = 0; i < blocks.size(); i++) {
+            ::operator delete(blocks[i]);
+        }
+        blocks.clear();
+        used = 0;
+        nodeCount = 0;
+    }
+
+    // 按分配顺序下标访问节点
+    T& operator[](size_t index) { return blocks[index / blockSize][index % blockSize]; }
+    const T& operator[](size_t index) const { return blocks[index / blockSize][index % blockSize]; }
+
+    size_t size() const { return nodeCount; }
+
+    // 已向系统申请的字节数（池只增不减，即本次求解的峰值）
+    size_t bytesReserved() const { return blocks.size() * blockSize * sizeof(T); }
+
+private:
+    NodeArena(const NodeArena&);
+    NodeArena& operator=(const NodeArena&);
+
+    vector<T*> blocks;
+    size_t blockSize;
+    size_t used;        // 最后一块已使用的节点数
+    size_t nodeCount;
+};
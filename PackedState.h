@@ -0,0 +1,408 @@
+﻿#pragma once
+// ==================== 位压缩状态 ====================
+// 每个试管压缩为一个64位字：第j个半字节(4位)为自底向上第j格的颜色，0表示空格。
+// 水总是从底部连续堆叠，因此试管高度 = 最高非零半字节位置 + 1，无需单独存储。
+// PackedState 是展开时用的工作值：按最大规格（16个试管）定长，共136字节，无堆分配，单试管操作只是位运算。
+// 需要大量存放时用 encode() 转成稠密编码，只占 packedWords(试管数, 容量) 个字，例如 12 个试管、容量 4 只需 24 字节。
+#include <stdint.h>
+#include <string.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+const int PACKED_MAX_TUBES = 16;      // 最多试管数
+const int PACKED_MAX_CAPACITY = 16;   // 单个试管最多格数（64位 / 4位）
+const int PACKED_MAX_COLOR = 15;      // 4位颜色编码的最大颜色号
+
+const uint64_t NIBBLE_ONES = 0x1111111111111111ULL;
+
+// 64位字的有效位数（最高置位位置+1），0 返回 0
+inline int packedBitLength(uint64_t x) {
+    if (x == 0) return 0;
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return (int)index + 1;
+#else
+    return 64 - __builtin_clzll(x);
+#endif
+}
+
+// 最低置位位置，x 不能为 0
+inline int packedTrailingZeros(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, x);
+    return (int)index;
+#else
+    return __builtin_ctzll(x);
+#endif
+}
+
+inline int packedPopcount(uint64_t x) {
+#ifdef _MSC_VER
+    return (int)__popcnt64(x);
+#else
+    return __builtin_popcountll(x);
+#endif
+}
+
+// 稠密编码所需的64位字数：n 个试管各 m 格，每格4位依次拼接
+inline int packedWords(int numTubes, int capacity) {
+    return (numTubes * capacity * 4 + 63) / 64;
+}
+
+// 稠密编码逐字比较，返回负数、0、正数；给出的全序与 PackedState::operator< 相同
+inline int comparePackedWords(const uint64_t* a, const uint64_t* b, int words) {
+    for (int i = 0; i < words; i++) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// 低 count 个半字节的掩码
+inline uint64_t nibbleMask(int count) {
+    return count >= 16 ? ~0ULL : ((1ULL << (4 * count)) - 1);
+}
+
+// 把每个非零半字节折叠为其最低位（结果只在每个半字节的 bit0 上有值）
+inline uint64_t nonZeroNibbles(uint64_t x) {
+    return (x | (x >> 1) | (x >> 2) | (x >> 3)) & NIBBLE_ONES;
+}
+
+// 低 count 个半字节中是否有等于 color 的
+inline bool nibblesContain(uint64_t word, int count, int color) {
+    uint64_t diff = word ^ ((uint64_t)color * NIBBLE_ONES);
+    return (~nonZeroNibbles(diff) & NIBBLE_ONES & nibbleMask(count)) != 0;
+}
+
+struct PackedState {
+    uint64_t tubes[PACKED_MAX_TUBES];  // 未使用的试管字保持为0
+    uint8_t numTubes;
+    uint8_t capacity;
+
+    PackedState() { reset(0, 0); }
+
+    void reset(int n, int m) {
+        memset(tubes, 0, sizeof(tubes));
+        numTubes = (uint8_t)n;
+        capacity = (uint8_t)m;
+    }
+
+    int colorAt(int i, int j) const { return (int)((tubes[i] >> (4 * j)) & 0xF); }
+    int tubeSize(int i) const { return (packedBitLength(tubes[i]) + 3) / 4; }
+    bool isEmpty(int i) const { return tubes[i] == 0; }
+    bool isFull(int i) const { return tubeSize(i) >= capacity; }
+    int freeSpace(int i) const { return capacity - tubeSize(i); }
+
+    // 第一个空试管的下标，没有则返回-1
+    int firstEmptyTube() const {
+        for (int i = 0; i < numTubes; i++) {
+            if (tubes[i] == 0) return i;
+        }
+        return -1;
+    }
+
+    // 获取顶部颜色，空试管返回-1
+    int topColor(int i) const {
+        int size = tubeSize(i);
+        return size == 0 ? -1 : colorAt(i, size - 1);
+    }
+
+    // 在试管顶部追加一格颜色（构建状态用）
+    void push(int i, int color) {
+        tubes[i] |= (uint64_t)color << (4 * tubeSize(i));
+    }
+
+    // 获取顶部连续同色水的数量：与顶色的重复模式异或后，顶段变为0
+    int topSegmentSize(int i) const {
+        int size = tubeSize(i);
+        if (size == 0) return 0;
+        uint64_t diff = (tubes[i] ^ (colorAt(i, size - 1) * NIBBLE_ONES)) & nibbleMask(size);
+        return size - (packedBitLength(diff) + 3) / 4;
+    }
+
+    // 获取底部连续同色水的数量
+    int bottomSegmentSize(int i) const {
+        int size = tubeSize(i);
+        if (size == 0) return 0;
+        uint64_t diff = (tubes[i] ^ (colorAt(i, 0) * NIBBLE_ONES)) & nibbleMask(size);
+        return diff == 0 ? size : packedTrailingZeros(diff) / 4;
+    }
+
+    // 检查试管是否已完成（只有一种颜色或为空）
+    bool isComplete(int i) const {
+        int size = tubeSize(i);
+        if (size == 0) return true;
+        return ((tubes[i] ^ (colorAt(i, 0) * NIBBLE_ONES)) & nibbleMask(size)) == 0;
+    }
+
+    // 试管内相邻颜色变化的次数
+    int colorChanges(int i) const {
+        int size = tubeSize(i);
+        if (size <= 1) return 0;
+        uint64_t diff = (tubes[i] ^ (tubes[i] >> 4)) & nibbleMask(size - 1);
+        return packedPopcount(nonZeroNibbles(diff));
+    }
+
+    // 计算从 from 倒入 to 的数量，非法转移返回0
+    int pourAmount(int from, int to) const {
+        if (from == to || isEmpty(from)) return 0;
+        int toSize = tubeSize(to);
+        if (toSize >= capacity) return 0;
+        int color = topColor(from);
+        if (toSize > 0 && colorAt(to, toSize - 1) != color) return 0;
+        int segment = topSegmentSize(from);
+        int space = capacity - toSize;
+        return segment < space ? segment : space;
+    }
+
+    // 执行倒水，返回倒出的数量（0 表示非法转移，状态不变）
+    int pour(int from, int to) {
+        int amount = pourAmount(from, to);
+        if (amount > 0) applyPour(from, to, amount);
+        return amount;
+    }
+
+    // 执行已知合法、倒水量已算好的移动（由 MoveIterator 产生），省去重复校验
+    void applyPour(int from, int to, int amount) {
+        int fromSize = tubeSize(from);
+        int toSize = tubeSize(to);
+        uint64_t color = (uint64_t)colorAt(from, fromSize - 1);
+        tubes[from] &= nibbleMask(fromSize - amount);
+        tubes[to] |= ((color * NIBBLE_ONES) & nibbleMask(amount)) << (4 * toSize);
+    }
+
+    // 计算启发式代价：与 GameState::calculateHeuristic 一致
+    int calculateHeuristic() const {
+        int cost = 0;
+        for (int i = 0; i < numTubes; i++) {
+            cost += colorChanges(i);
+        }
+        return cost / 2;
+    }
+
+    // 检查是否为目标状态：每个非空试管单色、每种颜色只在一个试管中、空瓶数与初始一致
+    bool isGoal(int initialEmptyTubes) const {
+        uint32_t seenColors = 0;
+        int emptyCount = 0;
+        for (int i = 0; i < numTubes; i++) {
+            if (tubes[i] == 0) {
+                emptyCount++;
+                continue;
+            }
+            if (!isComplete(i)) return false;
+            uint32_t bit = 1u << (tubes[i] & 0xF);
+            if (seenColors & bit) return false;
+            seenColors |= bit;
+        }
+        return emptyCount == initialEmptyTubes;
+    }
+
+    // 试管排列规范形：试管顺序不影响可解性与最优步数，按试管字升序排列后
+    // 同一配置的所有排列（包括空试管位置不同）得到相同的键。
+    // 搜索中只把规范形作为去重键，队列里保留原始排列，因此移动仍是原始试管下标。
+    PackedState canonical() const {
+        PackedState result = *this;
+        for (int i = 1; i < numTubes; i++) {
+            uint64_t value = result.tubes[i];
+            int j = i - 1;
+            while (j >= 0 && result.tubes[j] > value) {
+                result.tubes[j + 1] = result.tubes[j];
+                j--;
+            }
+            result.tubes[j + 1] = value;
+        }
+        return result;
+    }
+
+    // 颜色重标号规范形：颜色编号可互换，按自底向上、逐试管首次出现的顺序重新编号为 1,2,3...
+    // 重标号前后的状态最优步数相同，缓存、距离表等可以此为键，最多缩小 k! 倍。
+    PackedState colorNormalized() const {
+        uint8_t relabel[PACKED_MAX_COLOR + 1] = { 0 };
+        int nextColor = 1;
+        PackedState result = *this;
+        for (int i = 0; i < numTubes; i++) {
+            uint64_t word = tubes[i];
+            uint64_t mapped = 0;
+            for (int j = 0; word != 0; j++, word >>= 4) {
+                int color = (int)(word & 0xF);
+                if (relabel[color] == 0) relabel[color] = (uint8_t)nextColor++;
+                mapped |= (uint64_t)relabel[color] << (4 * j);
+            }
+            result.tubes[i] = mapped;
+        }
+        return result;
+    }
+
+    // 同时消除试管排列与颜色编号的对称性：先排序再重标号再排序。
+    // 结果不一定是严格的唯一代表元（同一等价类可能落到少数几个键上），
+    // 但只会合并真正等价的状态，用作去重键是安全的。
+    PackedState symmetryReduced(bool tubeOrder, bool colorLabels) const {
+        if (!colorLabels) return tubeOrder ? canonical() : *this;
+        if (!tubeOrder) return colorNormalized();
+        return canonical().colorNormalized().canonical();
+    }
+
+    int words() const { return packedWords(numTubes, capacity); }
+
+    // 稠密编码：各试管字依次拼接成一个 words() 个字的大数，试管0在最高位，末尾不足一个字的低位补0。
+    // 试管字逐个比较与大数比较的顺序一致，排序后的稠密数组与按 operator< 排序相同
+    void encode(uint64_t* out) const {
+        int count = words();
+        for (int w = 0; w < count; w++) out[w] = 0;
+        int bits = 4 * capacity;
+        for (int i = 0, position = 0; i < numTubes; i++, position += bits) {
+            int w = position >> 6;
+            int end = (position & 63) + bits;     // 试管字在当前字中的结束位置（自最高位起）
+            if (end <= 64) {
+                out[w] |= tubes[i] << (64 - end);
+            }
+            else {
+                out[w] |= tubes[i] >> (end - 64);
+                out[w + 1] |= tubes[i] << (128 - end);
+            }
+        }
+    }
+
+    void decode(const uint64_t* in, int n, int m) {
+        reset(n, m);
+        int bits = 4 * m;
+        uint64_t mask = nibbleMask(m);
+        for (int i = 0, position = 0; i < n; i++, position += bits) {
+            int w = position >> 6;
+            int end = (position & 63) + bits;
+            uint64_t value = end <= 64 ? in[w] >> (64 - end) : (in[w] << (end - 64)) | (in[w + 1] >> (128 - end));
+            tubes[i] = value & mask;
+        }
+    }
+
+    uint64_t hash() const {
+        uint64_t h = 0x9E3779B97F4A7C15ULL ^ numTubes;
+        for (int i = 0; i < numTubes; i++) {
+            h ^= tubes[i];
+            h *= 0xBF58476D1CE4E5B9ULL;
+            h ^= h >> 31;
+        }
+        h *= 0x94D049BB133111EBULL;
+        return h ^ (h >> 29);
+    }
+
+    bool operator==(const PackedState& other) const {
+        return numTubes == other.numTubes && capacity == other.capacity &&
+            memcmp(tubes, other.tubes, numTubes * sizeof(uint64_t)) == 0;
+    }
+    bool operator!=(const PackedState& other) const { return !(*this == other); }
+
+    // 按试管字逐个比较的全序（同一关卡中试管数与容量相同），供分层 BFS 排序去重
+    bool operator<(const PackedState& other) const {
+        for (int i = 0; i < numTubes; i++) {
+            if (tubes[i] != other.tubes[i]) return tubes[i] < other.tubes[i];
+        }
+        return false;
+    }
+};
+
+// A* 可选的启发函数
+enum HeuristicType {
+    HEURISTIC_COLOR_CHANGES = 0,    // 相邻颜色变化数的一半（原启发函数）
+    HEURISTIC_BLOCKS,               // 异色底上的色块数 + 各颜色多余的底块数
+    HEURISTIC_ASSIGNMENT,           // 颜色到目标试管的最小代价分配（见 AssignmentHeuristic.h）
+    HEURISTIC_COUNT
+};
+
+// ==================== 增量状态统计 ====================
+// 与状态并存的摘要信息。一次倒水只改变两个试管，apply() 用常数次位运算更新，
+// 使启发值与目标判定都变为直接读取，而不必每次重扫全部试管。
+struct StateMetrics {
+    int colorChanges;       // 所有试管内相邻颜色变化总数（为0即每个试管单色）
+    int completedTubes;     // 装满且单色的试管数
+    int emptyTubes;         // 空试管数
+    int splitColors;        // 分布在多于一个试管中的颜色数
+    int surplusBottoms;     // 各颜色作为试管底色的次数超出1的部分之和
+    uint16_t colorTubes[PACKED_MAX_COLOR + 1];  // 每种颜色所在试管的位掩码
+    uint8_t bottomTubes[PACKED_MAX_COLOR + 1];  // 每种颜色作为底色的试管数
+
+    void compute(const PackedState& state) {
+        colorChanges = 0;
+        completedTubes = 0;
+        emptyTubes = 0;
+        splitColors = 0;
+        surplusBottoms = 0;
+        memset(colorTubes, 0, sizeof(colorTubes));
+        memset(bottomTubes, 0, sizeof(bottomTubes));
+
+        for (int i = 0; i < state.numTubes; i++) {
+            int size = state.tubeSize(i);
+            if (size == 0) {
+                emptyTubes++;
+                continue;
+            }
+            colorChanges += state.colorChanges(i);
+            if (size == state.capacity && state.isComplete(i)) completedTubes++;
+            bottomTubes[state.colorAt(i, 0)]++;
+            for (int j = 0; j < size; j++) {
+                colorTubes[state.colorAt(i, j)] |= (uint16_t)(1u << i);
+            }
+        }
+        for (int c = 1; c <= PACKED_MAX_COLOR; c++) {
+            if (packedPopcount(colorTubes[c]) > 1) splitColors++;
+            if (bottomTubes[c] > 1) surplusBottoms += bottomTubes[c] - 1;
+        }
+    }
+
+    // 根据倒水前的状态 before 和合法移动 (from, to, amount) 更新统计
+    void apply(const PackedState& before, int from, int to, int amount) {
+        int fromSize = before.tubeSize(from);
+        int toSize = before.tubeSize(to);
+        int color = before.colorAt(from, fromSize - 1);
+        int segment = before.topSegmentSize(from);
+        int capacity = before.capacity;
+
+        // 源试管：整段倒出且下面还有水时，消除一处颜色变化；目标顶色必与倒入颜色相同，不新增变化
+        if (amount == segment && segment < fromSize) colorChanges--;
+
+        // 装满单色的试管：源试管倒出后不再装满；目标试管可能因此变为装满单色
+        if (fromSize == capacity && segment == fromSize) completedTubes--;
+        if (toSize + amount == capacity && before.isComplete(to)) completedTubes++;
+
+        if (amount == fromSize) {
+            emptyTubes++;
+            if (bottomTubes[color]-- > 1) surplusBottoms--;
+        }
+        if (toSize == 0) {
+            emptyTubes--;
+            if (bottomTubes[color]++ > 0) surplusBottoms++;
+        }
+
+        // 颜色位置：目标一定含该色；源试管只有剩余部分不再含该色时才清除
+        uint16_t beforeMask = colorTubes[color];
+        uint16_t mask = (uint16_t)(beforeMask | (1u << to));
+        if (!nibblesContain(before.tubes[from], fromSize - amount, color)) mask &= (uint16_t)~(1u << from);
+        colorTubes[color] = mask;
+
+        bool wasSplit = packedPopcount(beforeMask) > 1;
+        bool isSplit = packedPopcount(mask) > 1;
+        splitColors += (int)isSplit - (int)wasSplit;
+    }
+
+    // 启发值（均为可采纳且一致的下界）
+    // 一次倒水只可能消除源试管中倒出段下方的一处颜色变化，目标试管不会新增变化，
+    // 故 colorChanges 每步至多减1；底色只在倒空源试管或倒入空试管时改变，
+    // 且倒空源试管时不会同时消除颜色变化，因此 colorChanges + surplusBottoms 每步也至多减1。
+    // 目标状态下两者均为0。HEURISTIC_COLOR_CHANGES 保留原来减半的写法以便对比。
+    // HEURISTIC_ASSIGNMENT 需要代价矩阵，这里退化为 HEURISTIC_BLOCKS（它的下界）
+    int heuristic(int type) const {
+        if (type == HEURISTIC_BLOCKS || type == HEURISTIC_ASSIGNMENT) return colorChanges + surplusBottoms;
+        return colorChanges / 2;
+    }
+
+    // 与 PackedState::isGoal 等价的目标判定
+    bool isGoal(int initialEmptyTubes) const {
+        return colorChanges == 0 && splitColors == 0 && emptyTubes == initialEmptyTubes;
+    }
+};
+
+struct PackedStateHash {
+    size_t operator()(const PackedState& state) const { return (size_t)state.hash(); }
+};
@@ -0,0 +1,105 @@
+﻿#pragma once
+// ==================== 稠密状态数组 ====================
+// 一批试管数、容量相同的状态，按 PackedState::encode 的稠密编码连续存放，每个状态 packedWords(n, m) 个字。
+// 分层 BFS 的各层、外存 BFS 的生成缓冲区和束搜索的层都用它代替 vector<PackedState>。
+// 按编码排序与按 PackedState::operator< 排序结果相同。
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include "PackedState.h"
+
+using namespace std;
+
+class PackedStateArray {
+public:
+    PackedStateArray() : numTubes(0), capacity(0), stride(0) {}
+
+    // 设定状态规格并清空
+    void reset(int tubes, int cap) {
+        numTubes = tubes;
+        capacity = cap;
+        stride = packedWords(tubes, cap);
+        data.clear();
+    }
+
+    size_t size() const { return stride == 0 ? 0 : data.size() / stride; }
+    bool empty() const { return data.empty(); }
+    int words() const { return stride; }
+    void clear() { data.clear(); }
+    void reserve(size_t states) { data.reserve(states * stride); }
+    void shrink_to_fit() { data.shrink_to_fit(); }
+    void swap(PackedStateArray& other) {
+        std::swap(numTubes, other.numTubes);
+        std::swap(capacity, other.capacity);
+        std::swap(stride, other.stride);
+        data.swap(other.data);
+    }
+    size_t memoryBytes() const { return data.capacity() * sizeof(uint64_t); }
+
+    void push(const PackedState& state) {
+        size_t at = data.size();
+        data.resize(at + stride);
+        state.encode(&data[at]);
+    }
+
+    void pushRecord(const uint64_t* record) {
+        data.insert(data.end(), record, record + stride);
+    }
+
+    const uint64_t* record(size_t i) const { return &data[i * stride]; }
+    uint64_t* record(size_t i) { return &data[i * stride]; }
+
+    // 截断为前 states 个状态
+    void resize(size_t states) { data.resize(states * stride); }
+
+    PackedState operator[](size_t i) const {
+        PackedState state;
+        state.decode(record(i), numTubes, capacity);
+        return state;
+    }
+
+    // 排序并去重。每个状态一个字时直接排序，否则排序下标后按序搬移
+    void sortUnique() {
+        size_t count = size();
+        if (count <= 1) return;
+        if (stride == 1) {
+            sort(data.begin(), data.end());
+            data.erase(unique(data.begin(), data.end()), data.end());
+            return;
+        }
+
+        vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; i++) order[i] = (uint32_t)i;
+        const uint64_t* base = &data[0];
+        int width = stride;
+        sort(order.begin(), order.end(), [base, width](uint32_t a, uint32_t b) {
+            return comparePackedWords(base + (size_t)a * width, base + (size_t)b * width, width) < 0;
+        });
+        vector<uint64_t> sorted;
+        sorted.reserve(data.size());
+        for (size_t i = 0; i < count; i++) {
+            const uint64_t* item = base + (size_t)order[i] * width;
+            if (!sorted.empty() && comparePackedWords(&sorted[sorted.size() - width], item, width) == 0) continue;
+            sorted.insert(sorted.end(), item, item + width);
+        }
+        data.swap(sorted);
+    }
+
+    // 在已排序的数组中，从下标 first 起找第一个不小于 key 的记录
+    size_t lowerBound(size_t first, const uint64_t* key) const {
+        size_t last = size();
+        while (first < last) {
+            size_t middle = first + (last - first) / 2;
+            if (comparePackedWords(record(middle), key, stride) < 0) first = middle + 1;
+            else last = middle;
+        }
+        return first;
+    }
+
+private:
+    int numTubes;
+    int capacity;
+    int stride;
+    vector<uint64_t> data;
+};
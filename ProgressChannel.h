@@ -0,0 +1,66 @@
+﻿#pragma once
+// ==================== 求解进度通道 ====================
+// 求解线程按间隔发布进度快照，界面线程定时取走最新的一份。
+// 通道只保留最新快照，发布只是加锁复制几个数，搜索不会因界面绘制而变慢；界面错过的中间快照直接丢弃。
+// 组合求解的各成员可同时发布，快照中带有发布者的算法名。
+#include <mutex>
+#include <string>
+#include <chrono>
+
+using namespace std;
+
+struct ProgressSnapshot {
+    string algorithm;       // 发布快照的算法
+    int statesExplored;     // 已展开的状态数
+    int frontierSize;       // 待扩展队列/栈/开放表的当前长度，不可得时为 0
+    long long elapsedMs;    // 自 start() 起的毫秒数
+    double statesPerSecond; // 平均展开速度
+};
+
+class ProgressChannel {
+public:
+    ProgressChannel() : sequence(0) { start(); }
+
+    // 开始新一次求解：清空快照并重新计时，应在求解线程启动前调用
+    void start() {
+        lock_guard<mutex> guard(lock);
+        startTime = chrono::steady_clock::now();
+        latest.algorithm.clear();
+        latest.statesExplored = 0;
+        latest.frontierSize = 0;
+        latest.elapsedMs = 0;
+        latest.statesPerSecond = 0.0;
+        sequence++;
+    }
+
+    // 求解线程调用
+    void post(const char* algorithm, int statesExplored, size_t frontierSize) {
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        lock_guard<mutex> guard(lock);
+        long long elapsedMicros = chrono::duration_cast<chrono::microseconds>(now - startTime).count();
+        latest.algorithm = algorithm;
+        latest.statesExplored = statesExplored;
+        latest.frontierSize = (int)frontierSize;
+        latest.elapsedMs = elapsedMicros / 1000;
+        latest.statesPerSecond = elapsedMicros > 0 ? statesExplored * 1e6 / elapsedMicros : 0.0;
+        sequence++;
+    }
+
+    // 界面线程调用：有比 seen 更新的快照时复制到 out、更新 seen 并返回 true
+    bool poll(ProgressSnapshot& out, unsigned& seen) const {
+        lock_guard<mutex> guard(lock);
+        if (sequence == seen) return false;
+        out = latest;
+        seen = sequence;
+        return true;
+    }
+
+private:
+    ProgressChannel(const ProgressChannel&);
+    ProgressChannel& operator=(const ProgressChannel&);
+
+    mutable mutex lock;
+    chrono::steady_clock::time_point startTime;
+    ProgressSnapshot latest;
+    unsigned sequence;
+};
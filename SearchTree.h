@@ -0,0 +1,54 @@
+﻿#pragma once
+// ==================== 移动增量搜索树 ====================
+// 搜索树节点不保存完整状态，只记录 (父节点下标, 源试管, 目标试管, 倒水量)。
+// 待扩展队列中保存状态本身；找到目标后沿父下标回溯出移动序列，
+// 再从初始状态正向重放得到完整路径。
+#include <vector>
+#include <stdint.h>
+#include <algorithm>
+#include "NodeArena.h"
+
+using namespace std;
+
+struct MoveRecord {
+    int32_t parent;     // 父节点下标，-1 表示根节点
+    uint8_t from;       // 源试管
+    uint8_t to;         // 目标试管
+    uint8_t amount;     // 倒水量
+    uint8_t reserved;
+};
+
+class SearchTree {
+public:
+    SearchTree() : records(8192) {}
+
+    int addRoot() { return addChild(-1, 0, 0, 0); }
+
+    int addChild(int parent, int from, int to, int amount) {
+        MoveRecord* record = records.allocate();
+        record->parent = parent;
+        record->from = (uint8_t)from;
+        record->to = (uint8_t)to;
+        record->amount = (uint8_t)amount;
+        return (int)records.size() - 1;
+    }
+
+    const MoveRecord& operator[](int index) const { return records[index]; }
+
+    // 回溯得到从根到 node 的移动序列（不含根）
+    vector<MoveRecord> extractMoves(int node) const {
+        vector<MoveRecord> moves;
+        while (node >= 0 && records[node].parent >= 0) {
+            moves.push_back(records[node]);
+            node = records[node].parent;
+        }
+        reverse(moves.begin(), moves.end());
+        return moves;
+    }
+
+    size_t size() const { return records.size(); }
+    size_t bytesReserved() const { return records.bytesReserved(); }
+
+private:
+    NodeArena<MoveRecord> records;
+};
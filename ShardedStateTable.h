@@ -0,0 +1,72 @@
+﻿#pragma once
+// ==================== 分片并发状态表 ====================
+// 多线程共享的已访问表：按哈希高位分到若干个 StateTable，每个分片一把锁。
+// 分片数远多于线程数，不同线程同时命中同一分片的概率很低，锁几乎无竞争；
+// 分片内部仍是原来的开放寻址表，单线程性能不变。
+#include <mutex>
+#include <memory>
+#include <vector>
+#include "StateTable.h"
+
+using namespace std;
+
+template <typename Value>
+class ShardedStateTable {
+public:
+    explicit ShardedStateTable(size_t expectedStates = 0) {
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            shards[i].reset(new Shard(expectedStates / SHARD_COUNT));
+        }
+    }
+
+    // 查找 key，不存在则以 initial 插入；返回插入前（或刚插入）的值
+    Value insertOrFind(const PackedState& key, const Value& initial, bool& inserted) {
+        Shard& shard = *shards[shardOf(key)];
+        lock_guard<mutex> guard(shard.lock);
+        return *shard.table.insertOrFind(key, initial, inserted);
+    }
+
+    // 逐个分片压缩（见 StateTable::compact），需在没有其他线程访问时调用
+    void compact() {
+        for (int i = 0; i < SHARD_COUNT; i++) shards[i]->table.compact();
+    }
+
+    size_t size() const {
+        size_t total = 0;
+        for (int i = 0; i < SHARD_COUNT; i++) total += shards[i]->table.size();
+        return total;
+    }
+
+    // 各分片统计的汇总（探测数按分片查找次数近似加权）
+    StateTableStats stats() const {
+        StateTableStats total = { 0, 0, 0.0, 0.0, 0, 0, 0 };
+        double probeSum = 0.0;
+        for (int i = 0; i < SHARD_COUNT; i++) {
+            StateTableStats s = shards[i]->table.stats();
+            total.size += s.size;
+            total.capacity += s.capacity;
+            total.memoryBytes += s.memoryBytes;
+            total.rehashCount += s.rehashCount;
+            if (s.maxProbes > total.maxProbes) total.maxProbes = s.maxProbes;
+            probeSum += s.averageProbes * s.size;
+        }
+        total.loadFactor = total.capacity == 0 ? 0.0 : (double)total.size / total.capacity;
+        total.averageProbes = total.size == 0 ? 0.0 : probeSum / total.size;
+        return total;
+    }
+
+private:
+    struct Shard {
+        mutex lock;
+        StateTable<Value> table;
+
+        explicit Shard(size_t expectedStates) : table(expectedStates) {}
+    };
+
+    static const int SHARD_COUNT = 64;
+
+    // 分片内部用哈希低位定位槽位，分片选择用高位，二者互不相关
+    static int shardOf(const PackedState& key) { return (int)(key.hash() >> 58); }
+
+    unique_ptr<Shard> shards[SHARD_COUNT];
+};
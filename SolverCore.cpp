@@ -0,0 +1,2760 @@
+﻿#define _CRT_SECURE_NO_WARNINGS
+#include "SolverCore.h"
+#include "ShardedStateTable.h"
+#include "WideState.h"
+#include "PackedStateArray.h"
+#include "DiskRun.h"
+#include "DeadStateCache.h"
+#include <queue>
+#include <stack>
+#include <map>
+#include <algorithm>
+#include <iterator>
+#include <chrono>
+#include <climits>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+
+using namespace chrono;
+
+const char* GetColorName(int index) {
+    static const char* names[] = {
+        "空", "红", "绿", "蓝", "黄",
+        "紫", "青", "橙", "灰", "粉",
+        "薄荷", "淡紫"
+    };
+    if (index < 0 || index >= 12) return "未知";
+    return names[index];
+}
+
+const char* GetPruneRuleName(int rule) {
+    static const char* names[] = {
+        "单色倒空瓶", "多余空瓶", "撤销上一步", "已完成试管", "死状态"
+    };
+    if (rule < 0 || rule >= PRUNE_RULE_COUNT) return "未知";
+    return names[rule];
+}
+
+const char* GetHeuristicName(int heuristic) {
+    static const char* names[] = { "颜色变化", "颜色块", "颜色分配" };
+    if (heuristic < 0 || heuristic >= HEURISTIC_COUNT) return "未知";
+    return names[heuristic];
+}
+
+const char* GetMemoryActionName(int action) {
+    static const char* names[] = { "未触发", "放弃", "改用IDA*", "压缩" };
+    if (action < 0 || action >= MEMORY_ACTION_COUNT) return "未知";
+    return names[action];
+}
+
+// 统计状态中的空试管数
+int countEmptyTubes(const GameState& state) {
+    int count = 0;
+    for (const auto& tube : state.tubes) {
+        if (tube.isEmpty()) count++;
+    }
+    return count;
+}
+
+// 检查是否为目标状态（符合新规则）
+bool isGoalState(const GameState& state, int initialEmptyTubes) {
+    // 1. 检查每种颜色是否只出现在一个瓶子中
+    map<int, int> colorToTubeMap; // 颜色 -> 瓶子索引
+    for (int i = 0; i < (int)state.tubes.size(); i++) {
+        const Tube& tube = state.tubes[i];
+        if (tube.isEmpty()) continue; // 空瓶跳过
+
+        // 检查瓶子内部是否只有一种颜色
+        if (!tube.isComplete()) return false;
+
+        int tubeColor = tube.colors[0];
+
+        // 检查该颜色是否已出现在其他瓶子
+        if (colorToTubeMap.find(tubeColor) != colorToTubeMap.end()) {
+            return false; // 该颜色已出现在其他瓶
+        }
+        colorToTubeMap[tubeColor] = i;
+    }
+
+    // 2. 检查空瓶数量是否与初始状态一致
+    return countEmptyTubes(state) == initialEmptyTubes;
+}
+
+// 从路径中提取移动序列
+vector<string> extractMoveSequence(const vector<GameState>& path) {
+    vector<string> moves;
+
+    // 从第二个状态开始（第一个是初始状态）
+    for (size_t i = 1; i < path.size(); i++) {
+        moves.push_back(path[i].getMoveDescription());
+    }
+
+    return moves;
+}
+
+// 打印解决方案到控制台
+void printSolutionToConsole(const vector<GameState>& path, const string& algorithm) {
+    if (path.empty()) return;
+
+    printf("\n================ %s算法求解完成 ================\n", algorithm.c_str());
+    printf("解决方案（共%d步）:\n", (int)path.size() - 1);
+    printf("==============================================\n");
+
+    for (size_t i = 1; i < path.size(); i++) {
+        printf("第%2d步: %s\n", (int)i, path[i].getMoveDescription().c_str());
+    }
+
+    printf("==============================================\n");
+    printf("初始状态:\n");
+    for (size_t i = 0; i < path[0].tubes.size(); i++) {
+        printf("  试管%d: ", (int)i + 1);
+        if (path[0].tubes[i].isEmpty()) {
+            printf("空");
+        }
+        else {
+            for (int color : path[0].tubes[i].colors) {
+                printf("%s ", GetColorName(color));
+            }
+        }
+        printf("\n");
+    }
+
+    printf("\n最终状态:\n");
+    for (size_t i = 0; i < path.back().tubes.size(); i++) {
+        printf("  试管%d: ", (int)i + 1);
+        if (path.back().tubes[i].isEmpty()) {
+            printf("空");
+        }
+        else {
+            for (int color : path.back().tubes[i].colors) {
+                printf("%s ", GetColorName(color));
+            }
+        }
+        printf("\n");
+    }
+    printf("==============================================\n\n");
+}
+
+// ==================== 位编码状态转换 ====================
+bool packState(const GameState& state, PackedState& packed) {
+    int n = (int)state.tubes.size();
+    if (n > PACKED_MAX_TUBES) return false;
+
+    int capacity = n > 0 ? state.tubes[0].capacity : 0;
+    if (capacity > PACKED_MAX_CAPACITY) return false;
+
+    packed.reset(n, capacity);
+    for (int i = 0; i < n; i++) {
+        const Tube& tube = state.tubes[i];
+        if (tube.capacity != capacity || tube.isOverCapacity()) return false;
+        for (int color : tube.colors) {
+            if (color <= 0 || color > PACKED_MAX_COLOR) return false;
+            packed.push(i, color);
+        }
+    }
+    return true;
+}
+
+GameState unpackState(const PackedState& packed) {
+    GameState state;
+    for (int i = 0; i < packed.numTubes; i++) {
+        Tube tube(packed.capacity);
+        int size = packed.tubeSize(i);
+        for (int j = 0; j < size; j++) {
+            tube.colors.push_back(packed.colorAt(i, j));
+        }
+        state.tubes.push_back(tube);
+    }
+    return state;
+}
+
+// 从初始状态正向重放移动序列，得到完整路径（含初始状态）
+void replayMoves(const GameState& start, const vector<MoveRecord>& moves, vector<GameState>& path) {
+    path.clear();
+    path.reserve(moves.size() + 1);
+
+    GameState state = start;
+    state.operation = "初始状态";
+    state.parent = NULL;
+    state.gCost = 0;
+    state.hCost = state.calculateHeuristic();
+    state.moveFrom = -1;
+    state.moveTo = -1;
+    state.moveAmount = 0;
+    state.isInvalid = false;
+    path.push_back(state);
+
+    for (size_t i = 0; i < moves.size(); i++) {
+        int from = moves[i].from;
+        int to = moves[i].to;
+        int amount = moves[i].amount;
+        int color = state.tubes[from].topColor();
+
+        state.tubes[from].pourOut(amount);
+        state.tubes[to].pourIn(color, amount);
+        state.moveFrom = from;
+        state.moveTo = to;
+        state.moveAmount = amount;
+        state.gCost = (int)i + 1;
+        state.hCost = state.calculateHeuristic();
+
+        char op[100];
+        sprintf(op, "%d→%d (颜色%d, %d单位)", from + 1, to + 1, color, amount);
+        state.operation = op;
+        path.push_back(state);
+    }
+}
+
+// ==================== 算法实现 ====================
+
+// 待扩展的状态：完整状态只存在于队列中，出队后只剩搜索树里的移动记录
+struct FrontierEntry {
+    PackedState state;
+    StateMetrics metrics;   // 随移动增量维护的目标判定与启发信息
+    int node;       // 搜索树节点下标
+    int gCost;
+};
+
+// 清空上一次求解的输出
+static void resetOutputs(SolverContext& ctx) {
+    ctx.solutionPath.clear();
+    ctx.noSolutionReason = "";
+    ctx.totalStatesExplored = 0;
+    ctx.maxStatesInMemory = 0;
+    ctx.peakMemoryBytes = 0;
+    ctx.threadsUsed = 1;
+    ctx.parallelSpeedup = 1.0;
+    ctx.cancelled = false;
+    ctx.suboptimalityBound = 0.0;
+    ctx.beamWidthUsed = 0;
+    ctx.externalDiskBytes = 0;
+    ctx.memoryActionTaken = MEMORY_NONE;
+    for (int i = 0; i < PRUNE_RULE_COUNT; i++) {
+        ctx.prunedByRule[i] = 0;
+    }
+}
+
+// 检查初始状态并转换为位编码，失败时写入原因
+static bool prepareStart(const GameState& start, SolverContext& ctx, PackedState& packed) {
+    resetOutputs(ctx);
+    if (start.isInvalid) {
+        ctx.noSolutionReason = "无解：初始状态无效";
+        return false;
+    }
+    if (!packState(start, packed)) {
+        ctx.noSolutionReason = "无法求解：超出位编码范围（最多16个试管、容量16、颜色15）";
+        return false;
+    }
+    return true;
+}
+
+// 已访问表使用的去重键
+static inline PackedState visitedKey(const PackedState& state, const SolverContext& ctx) {
+    return state.symmetryReduced(ctx.canonicalizeTubes, ctx.canonicalizeColors);
+}
+
+// 剪枝层：判断移动是否被某条启用的规则排除，并计入该规则的统计（多线程时各线程传入自己的计数数组）。
+// State 为 PackedState 或束搜索的 WideState，只用到 isEmpty、isFull、isComplete
+template <typename State>
+static bool isPrunedMove(unsigned rules, long long prunedByRule[], const State& state, const PourMove& move,
+    const MoveRecord& lastMove, int firstEmpty) {
+    int from = move.from;
+    int to = move.to;
+    int amount = move.amount;
+    int rule = -1;
+
+    if ((rules & (1u << PRUNE_UNIFORM_TO_EMPTY)) && state.isEmpty(to) && state.isComplete(from)) {
+        rule = PRUNE_UNIFORM_TO_EMPTY;
+    }
+    else if ((rules & (1u << PRUNE_EXTRA_EMPTY)) && state.isEmpty(to) && to != firstEmpty) {
+        rule = PRUNE_EXTRA_EMPTY;
+    }
+    else if ((rules & (1u << PRUNE_UNDO)) && lastMove.parent >= 0 &&
+        lastMove.from == to && lastMove.to == from && lastMove.amount == amount) {
+        rule = PRUNE_UNDO;
+    }
+    else if ((rules & (1u << PRUNE_COMPLETED)) && state.isFull(from) && state.isComplete(from)) {
+        rule = PRUNE_COMPLETED;
+    }
+
+    if (rule < 0) return false;
+    prunedByRule[rule]++;
+    return true;
+}
+
+template <typename State>
+static inline bool isPrunedMove(SolverContext& ctx, const State& state, const PourMove& move,
+    const MoveRecord& lastMove, int firstEmpty) {
+    return isPrunedMove(ctx.pruneRules, ctx.prunedByRule, state, move, lastMove, firstEmpty);
+}
+
+// ==================== 死状态剪枝 ====================
+// 只用于 IDA*：BFS、DFS 与 A* 的已访问表本来就让每个状态至多展开一次，穷举死区与直接搜索它的开销相同；
+// IDA* 每轮从头展开、置换表也会丢弃条目，同一块死区会被反复进入，缓存后只需穷举一次。
+const int DEAD_PROBE_MAX_MOVES = 2;         // 合法移动不多于此数的状态才穷举其闭包，多数状态不必付出穷举的开销
+const size_t DEAD_PROBE_STATES = 64;        // 单次穷举的状态数上限
+const size_t DEAD_CACHE_STATES = 1 << 16;   // 死状态缓存的容量上限
+
+// 展开 state 前调用：合法移动很少时穷举其闭包，证明到不了目标则整块记入缓存，调用者不再展开它
+static bool provesDeadState(SolverContext& ctx, DeadStateCache& dead, const PackedState& state, const PackedState& key) {
+    if (!(ctx.pruneRules & (1u << PRUNE_DEAD_STATE))) return false;
+    MoveIterator moves(state);
+    PourMove move;
+    int count = 0;
+    while (moves.next(move)) {
+        if (++count > DEAD_PROBE_MAX_MOVES) return false;
+    }
+    if (!dead.probe(key, ctx.initialEmptyTubes, ctx.canonicalizeTubes, ctx.canonicalizeColors, DEAD_PROBE_STATES)) return false;
+    ctx.prunedByRule[PRUNE_DEAD_STATE]++;
+    return true;
+}
+
+// 生成后继时调用：后继的去重键在死状态缓存中则剪掉
+static inline bool isDeadState(SolverContext& ctx, DeadStateCache& dead, const PackedState& key) {
+    if (!(ctx.pruneRules & (1u << PRUNE_DEAD_STATE)) || !dead.contains(key)) return false;
+    ctx.prunedByRule[PRUNE_DEAD_STATE]++;
+    return true;
+}
+
+// 是否因超出内存预算而停止了搜索（压缩后继续的不算）
+static inline bool stoppedByMemory(const SolverContext& ctx) {
+    return ctx.memoryActionTaken == MEMORY_ABORT;
+}
+
+// 记录算法统计
+static void recordStats(SolverContext& ctx, const char* algorithmName, bool found) {
+    ctx.stats.statesExplored = ctx.totalStatesExplored;
+    ctx.stats.maxMemory = ctx.maxStatesInMemory;
+    ctx.stats.solvingTime = ctx.solvingTime;
+    ctx.stats.solutionLength = found ? (int)ctx.solutionPath.size() - 1 : 0;
+    ctx.stats.algorithmName = algorithmName;
+    ctx.stats.hasSolution = found;
+    ctx.stats.solutionStatus = found ? "有解" : (ctx.cancelled ? "已取消" : "无解");
+    ctx.stats.peakMemoryBytes = ctx.peakMemoryBytes;
+    for (int i = 0; i < PRUNE_RULE_COUNT; i++) {
+        ctx.stats.prunedByRule[i] = ctx.prunedByRule[i];
+    }
+    ctx.stats.memoryBudgetBytes = ctx.memoryBudgetBytes;
+    ctx.stats.memoryAction = ctx.memoryActionTaken;
+
+    if (!found && ctx.cancelled) {
+        ctx.noSolutionReason = "已取消";
+    }
+    else if (!found && stoppedByMemory(ctx)) {
+        char reason[160];
+        sprintf(reason, "超出内存预算（%.1f MB），已放弃搜索（不能据此判定无解）", ctx.memoryBudgetBytes / 1048576.0);
+        ctx.noSolutionReason = reason;
+        ctx.stats.solutionStatus = "超出内存";
+    }
+    if (!found && ctx.noSolutionReason.empty()) {
+        ctx.noSolutionReason = "无解：搜索后未找到解决方案";
+    }
+}
+
+// 回调进度并向进度通道发布快照；frontier 为待扩展的状态数
+static void publishProgress(const SolverContext& ctx, const char* algorithmName, int statesExplored, size_t frontier) {
+    if (ctx.onProgress) ctx.onProgress(algorithmName, statesExplored);
+    if (ctx.progressChannel != NULL) ctx.progressChannel->post(algorithmName, statesExplored, frontier);
+}
+
+// 按间隔回调进度
+static void reportProgress(const SolverContext& ctx, const char* algorithmName, size_t frontier) {
+    if (ctx.progressInterval > 0 && ctx.totalStatesExplored % ctx.progressInterval == 0) {
+        publishProgress(ctx, algorithmName, ctx.totalStatesExplored, frontier);
+    }
+}
+
+// 协作式取消：各搜索循环每展开一个状态检查一次
+static inline bool isCancelled(const SolverContext& ctx) {
+    return ctx.cancelFlag != NULL && ctx.cancelFlag->load(memory_order_relaxed);
+}
+
+// ==================== 内存预算 ====================
+// 各求解器按实际分配量（节点池、各表的槽位数组、队列与堆中的条目）计算当前内存，
+// 每展开 MEMORY_CHECK_INTERVAL 个状态（按层同步的算法每层）与 memoryBudgetBytes 比较一次。
+// 超出时按 memoryAction 处理：压缩只做一次，压缩后仍超出或选择其他处理时停止搜索并记为 MEMORY_ABORT；
+// 改用 IDA* 由 SolveWithAlgorithm 在求解函数返回后进行，完成后记为 MEMORY_FALLBACK。
+const int MEMORY_CHECK_INTERVAL = 1024;
+
+static inline bool memoryCheckDue(const SolverContext& ctx) {
+    return ctx.memoryBudgetBytes > 0 && ctx.totalStatesExplored % MEMORY_CHECK_INTERVAL == 0;
+}
+
+// measure() 返回当前内存字节数，compact() 压缩本算法的表；返回 true 表示应停止搜索
+template <typename Measure, typename Compact>
+static bool overMemoryBudget(SolverContext& ctx, Measure measure, Compact compact) {
+    if (ctx.memoryBudgetBytes <= 0 || measure() <= ctx.memoryBudgetBytes) return false;
+    if (ctx.memoryAction == MEMORY_COMPACT && ctx.memoryActionTaken == MEMORY_NONE) {
+        ctx.memoryActionTaken = MEMORY_COMPACT;
+        compact();
+        if (measure() <= ctx.memoryBudgetBytes) return false;
+    }
+    ctx.memoryActionTaken = MEMORY_ABORT;
+    return true;
+}
+
+// 没有可压缩的表的算法
+template <typename Measure>
+static bool overMemoryBudget(SolverContext& ctx, Measure measure) {
+    return overMemoryBudget(ctx, measure, []() {});
+}
+
+// 加权 A* 的启发值 w*h；w 为1时即原启发值
+static inline int weightedHeuristic(int h, const SolverContext& ctx) {
+    return ctx.heuristicWeight == 1.0 ? h : (int)(h * ctx.heuristicWeight + 0.5);
+}
+
+// ==================== 分层 BFS ====================
+// 每层是排序去重后的去重键数组（稠密编码）；整层生成完后批量排序，再与已存的各层多路归并相减。
+// 全程只有顺序扫描和排序，没有逐个后继的随机哈希访问。
+// 倒水一般不可逆，重复状态可能来自任何更早的层，因此与所有已存的层相减；每个状态只在所在层存一份。
+// 层中不存父指针：找到目标后逐层回溯，在上一层中顺序查找能一步到达的状态；
+// 层中存放的是去重键（试管重排、颜色重标号后的状态），再逐步求出键与原始状态间的对应，换算成实际移动。
+
+// 从有序数组 items 中删去 layers 任一层（各层均有序）中出现的状态。
+// 各层游标放进小顶堆多路归并，游标用二分查找直接跳到不小于当前状态的位置，不必逐个扫过各层
+static void subtractLayers(PackedStateArray& items, const vector<PackedStateArray>& layers) {
+    typedef pair<size_t, size_t> Cursor;    // 层号与层内下标
+    int words = items.words();
+    auto later = [&layers, words](const Cursor& a, const Cursor& b) {
+        return comparePackedWords(layers[b.first].record(b.second), layers[a.first].record(a.second), words) < 0;
+    };
+    vector<Cursor> heap;
+    for (size_t d = 0; d < layers.size(); d++) {
+        if (!layers[d].empty()) heap.push_back(Cursor(d, 0));
+    }
+    make_heap(heap.begin(), heap.end(), later);
+
+    size_t write = 0;
+    for (size_t i = 0; i < items.size(); i++) {
+        const uint64_t* item = items.record(i);
+        while (!heap.empty() && comparePackedWords(layers[heap.front().first].record(heap.front().second), item, words) < 0) {
+            pop_heap(heap.begin(), heap.end(), later);
+            Cursor& cursor = heap.back();
+            cursor.second = layers[cursor.first].lowerBound(cursor.second, item);
+            if (cursor.second == layers[cursor.first].size()) heap.pop_back();
+            else push_heap(heap.begin(), heap.end(), later);
+        }
+        if (!heap.empty() && comparePackedWords(layers[heap.front().first].record(heap.front().second), item, words) == 0) {
+            continue;
+        }
+        if (write != i) memcpy(items.record(write), item, words * sizeof(uint64_t));
+        write++;
+    }
+    items.resize(write);
+}
+
+// 在 state 的后继中找出去重键为 key 的移动
+static bool findMoveTo(const PackedState& state, const PackedState& key, const SolverContext& ctx, PourMove& found) {
+    MoveIterator moves(state);
+    PourMove move;
+    while (moves.next(move)) {
+        PackedState next = state;
+        next.applyPour(move.from, move.to, move.amount);
+        if (visitedKey(next, ctx) == key) {
+            found = move;
+            return true;
+        }
+    }
+    return false;
+}
+
+// 求试管对应 tubeMap，使 a 的第 i 个试管在重标号颜色后等于 b 的第 tubeMap[i] 个试管
+static bool matchTubes(const PackedState& a, const PackedState& b, int i, int tubeMap[], bool used[],
+    uint8_t colorMap[], uint8_t inverseMap[]) {
+    if (i == a.numTubes) return true;
+    int size = a.tubeSize(i);
+    for (int j = 0; j < b.numTubes; j++) {
+        if (used[j] || b.tubeSize(j) != size) continue;
+
+        // 逐格检查颜色对应是否一致，记录本层新建立的对应以便回退
+        uint8_t added[PACKED_MAX_CAPACITY];
+        int addedCount = 0;
+        bool consistent = true;
+        for (int k = 0; k < size && consistent; k++) {
+            int ca = a.colorAt(i, k);
+            int cb = b.colorAt(j, k);
+            if (colorMap[ca] == 0 && inverseMap[cb] == 0) {
+                colorMap[ca] = (uint8_t)cb;
+                inverseMap[cb] = (uint8_t)ca;
+                added[addedCount++] = (uint8_t)ca;
+            }
+            else if (colorMap[ca] != cb) {
+                consistent = false;
+            }
+        }
+
+        if (consistent) {
+            used[j] = true;
+            tubeMap[i] = j;
+            if (matchTubes(a, b, i + 1, tubeMap, used, colorMap, inverseMap)) return true;
+            used[j] = false;
+        }
+        for (int k = 0; k < addedCount; k++) {
+            inverseMap[colorMap[added[k]]] = 0;
+            colorMap[added[k]] = 0;
+        }
+    }
+    return false;
+}
+
+// a 与 b 在试管重排与颜色重标号下等价时，求出 a 的试管到 b 的试管的对应
+static bool findSymmetry(const PackedState& a, const PackedState& b, int tubeMap[]) {
+    bool used[PACKED_MAX_TUBES] = { false };
+    uint8_t colorMap[PACKED_MAX_COLOR + 1] = { 0 };
+    uint8_t inverseMap[PACKED_MAX_COLOR + 1] = { 0 };
+    return matchTubes(a, b, 0, tubeMap, used, colorMap, inverseMap);
+}
+
+// 把键空间中的移动序列按试管对应换算为从 startState 出发的实际移动
+static void keyPathToMoves(const PackedState& startState, const vector<PackedState>& keys,
+    const vector<PourMove>& keyMoves, vector<MoveRecord>& moves) {
+    PackedState state = startState;
+    for (size_t d = 0; d < keyMoves.size(); d++) {
+        int tubeMap[PACKED_MAX_TUBES];
+        findSymmetry(keys[d], state, tubeMap);
+        int from = tubeMap[keyMoves[d].from];
+        int to = tubeMap[keyMoves[d].to];
+        MoveRecord record = { 0, (uint8_t)from, (uint8_t)to, (uint8_t)keyMoves[d].amount, 0 };
+        moves.push_back(record);
+        state.applyPour(from, to, keyMoves[d].amount);
+    }
+}
+
+static bool layeredBFS(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "BFS", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    vector<PackedStateArray> layers;    // layers[d]：深度为 d 的全部状态（有序、无重复、稠密编码），每个状态只存这一份
+    PackedState goalKey = visitedKey(startState, ctx);
+    layers.push_back(PackedStateArray());
+    layers[0].reset(startState.numTubes, startState.capacity);
+    layers[0].push(goalKey);
+
+    StateMetrics startMetrics;
+    startMetrics.compute(startState);
+    bool found = startMetrics.isGoal(ctx.initialEmptyTubes);
+    size_t goalDepth = 0;
+    MoveRecord noMove = { -1, 0, 0, 0, 0 };     // 层中没有上一步移动，撤销剪枝不生效
+    size_t recordBytes = startState.words() * sizeof(uint64_t);
+    size_t storedStates = 1;
+    size_t storedBytes = layers[0].memoryBytes();
+    size_t peakBytes = storedBytes;
+
+    while (!found && !layers.back().empty()) {
+        const PackedStateArray& current = layers.back();
+        PackedStateArray next;
+        next.reset(startState.numTubes, startState.capacity);
+
+        // 生成下一层，生成时即做目标判定
+        for (size_t i = 0; i < current.size() && !found; i++) {
+            if (isCancelled(ctx)) {
+                ctx.cancelled = true;
+                break;
+            }
+            if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                    return (long long)(storedBytes + next.memoryBytes());
+                })) {
+                break;
+            }
+            PackedState state = current[i];
+            ctx.totalStatesExplored++;
+
+            StateMetrics metrics;
+            metrics.compute(state);
+            int firstEmpty = state.firstEmptyTube();
+            MoveIterator moves(state);
+            PourMove move;
+            while (moves.next(move)) {
+                if (isPrunedMove(ctx, state, move, noMove, firstEmpty)) continue;
+
+                PackedState child = state;
+                child.applyPour(move.from, move.to, move.amount);
+                StateMetrics childMetrics = metrics;
+                childMetrics.apply(state, move.from, move.to, move.amount);
+                if (childMetrics.isGoal(ctx.initialEmptyTubes)) {
+                    goalKey = visitedKey(child, ctx);
+                    goalDepth = layers.size();
+                    found = true;
+                    break;
+                }
+                next.push(visitedKey(child, ctx));
+            }
+
+            reportProgress(ctx, "BFS", current.size() - i - 1 + next.size());
+        }
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)(current.size() + next.size()));
+        // 多字编码排序时另需下标数组和一份排好的副本
+        size_t sortBytes = next.words() > 1 ? next.size() * (sizeof(uint32_t) + recordBytes) : 0;
+        peakBytes = max(peakBytes, storedBytes + next.memoryBytes() + sortBytes);
+        if (found || ctx.cancelled || stoppedByMemory(ctx)) break;
+
+        // 批量去重：层内排序去重，再与已存的各层多路归并相减
+        next.sortUnique();
+        subtractLayers(next, layers);
+        next.shrink_to_fit();
+
+        storedStates += next.size();
+        storedBytes += next.memoryBytes();
+        layers.push_back(PackedStateArray());
+        layers.back().swap(next);
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats.size = storedStates;
+    ctx.tableStats.capacity = storedStates;
+    ctx.tableStats.loadFactor = 1.0;
+    ctx.tableStats.averageProbes = 0.0;
+    ctx.tableStats.maxProbes = 0;
+    ctx.tableStats.rehashCount = 0;
+    ctx.tableStats.memoryBytes = storedBytes;
+    ctx.peakMemoryBytes = (long long)peakBytes;
+
+    if (found) {
+        // 逐层回溯去重键序列：keys[d] 为第 d 步之后的状态，keyMoves[d] 为键空间中从 keys[d] 出发的移动
+        vector<PackedState> keys(goalDepth + 1);
+        vector<PourMove> keyMoves(goalDepth);
+        keys[goalDepth] = goalKey;
+        for (size_t d = goalDepth; d > 0; d--) {
+            const PackedStateArray& layer = layers[d - 1];
+            for (size_t i = 0; i < layer.size(); i++) {
+                PackedState state = layer[i];
+                if (findMoveTo(state, keys[d], ctx, keyMoves[d - 1])) {
+                    keys[d - 1] = state;
+                    break;
+                }
+            }
+        }
+
+        vector<MoveRecord> moves;
+        keyPathToMoves(startState, keys, keyMoves, moves);
+        replayMoves(start, moves, ctx.solutionPath);
+    }
+    recordStats(ctx, "BFS", found);
+    return found;
+}
+
+// ==================== 外存 BFS ====================
+// 与分层 BFS 相同的按层同步搜索，但各层以及更早各层的并集都保存为 ctx.scratchDirectory 中的有序段文件（见 DiskRun.h）。
+// 内存中只有生成缓冲区和各段的读写缓冲区，合计不超过 ctx.externalMemoryBytes。
+// 生成下一层时，缓冲区满就排序去重写出一个有序段；整层生成完后多路归并这些段，
+// 同时与当前层、上一层和更早各层的并集归并相减，得到下一层文件。段数超过归并路数时先分批归并。
+// 找到目标后与分层 BFS 一样逐层顺序扫描回溯；临时文件在求解结束时删除。
+
+const int EXTERNAL_MERGE_FAN_IN = 32;               // 一次归并的最多输入段数
+const size_t EXTERNAL_MIN_BUFFER_RECORDS = 64;     // 每个读写缓冲区的最少记录数
+const size_t EXTERNAL_MIN_MEMORY = 1u << 20;
+
+// 本次求解的临时文件，析构时全部删除；同时统计仍在磁盘上的字节数
+struct ScratchFiles {
+    string prefix;
+    vector<pair<string, long long> > files;     // 路径与大小
+    int counter;
+    long long peakBytes;
+
+    explicit ScratchFiles(const string& directory) : counter(0), peakBytes(0) {
+        // 文件名含时钟计数与进程内序号，批量求解的多个线程可共用一个目录
+        static atomic<unsigned> sequence(0);
+        char name[64];
+        sprintf(name, "wsbfs_%llx_%u", (unsigned long long)high_resolution_clock::now().time_since_epoch().count(),
+            sequence.fetch_add(1));
+        prefix = (directory.empty() ? string(".") : directory) + "/" + name;
+    }
+
+    ~ScratchFiles() {
+        for (size_t i = 0; i < files.size(); i++) {
+            remove(files[i].first.c_str());
+        }
+    }
+
+    string create(const char* tag) {
+        char suffix[32];
+        sprintf(suffix, "_%s%d.bin", tag, counter++);
+        files.push_back(make_pair(prefix + suffix, 0LL));
+        return files.back().first;
+    }
+
+    void setSize(const string& path, long long bytes) {
+        long long total = 0;
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].first == path) files[i].second = bytes;
+            total += files[i].second;
+        }
+        peakBytes = max(peakBytes, total);
+    }
+
+    void release(const string& path) {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (files[i].first == path) {
+                remove(path.c_str());
+                files.erase(files.begin() + i);
+                return;
+            }
+        }
+    }
+};
+
+// 多路归并有序段 inputs 并去重，同时删去 exclude 各段中出现的状态，写入 output。
+// 返回写出的状态数，读写失败返回 -1；bufferBytes 为本次归并占用的缓冲区字节数
+static long long mergeRuns(const vector<string>& inputs, const vector<string>& exclude, const string& output,
+    const PackedState& shape, size_t bufferRecords, size_t& bufferBytes) {
+    vector<unique_ptr<StateRunReader> > readers;
+    vector<unique_ptr<StateRunReader> > excluded;
+    bool ok = true;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        readers.push_back(unique_ptr<StateRunReader>(new StateRunReader()));
+        ok = readers.back()->open(inputs[i], shape.numTubes, shape.capacity, bufferRecords) && ok;
+    }
+    for (size_t i = 0; i < exclude.size(); i++) {
+        excluded.push_back(unique_ptr<StateRunReader>(new StateRunReader()));
+        ok = excluded.back()->open(exclude[i], shape.numTubes, shape.capacity, bufferRecords) && ok;
+    }
+    StateRunWriter writer;
+    int words = shape.words();
+    ok = writer.open(output, words, bufferRecords) && ok;
+
+    bufferBytes = writer.bufferBytes();
+    for (size_t i = 0; i < readers.size(); i++) bufferBytes += readers[i]->bufferBytes();
+    for (size_t i = 0; i < excluded.size(); i++) bufferBytes += excluded[i]->bufferBytes();
+    if (!ok) return -1;
+
+    // 小顶堆：堆顶为当前最小状态所在的输入段
+    auto greater = [&readers, words](int a, int b) {
+        return comparePackedWords(readers[b]->record(), readers[a]->record(), words) < 0;
+    };
+    priority_queue<int, vector<int>, decltype(greater)> heap(greater);
+    for (size_t i = 0; i < readers.size(); i++) {
+        if (readers[i]->valid()) heap.push((int)i);
+    }
+
+    uint64_t state[PACKED_MAX_TUBES];
+    uint64_t last[PACKED_MAX_TUBES];
+    bool hasLast = false;
+    while (!heap.empty()) {
+        int i = heap.top();
+        heap.pop();
+        memcpy(state, readers[i]->record(), words * sizeof(uint64_t));
+        readers[i]->advance();
+        if (readers[i]->valid()) heap.push(i);
+
+        if (hasLast && comparePackedWords(state, last, words) == 0) continue;
+        memcpy(last, state, words * sizeof(uint64_t));
+        hasLast = true;
+
+        bool seen = false;
+        for (size_t j = 0; j < excluded.size() && !seen; j++) {
+            StateRunReader& other = *excluded[j];
+            while (other.valid() && comparePackedWords(other.record(), state, words) < 0) other.advance();
+            seen = other.valid() && comparePackedWords(other.record(), state, words) == 0;
+        }
+        if (!seen) writer.write(state);
+    }
+
+    for (size_t i = 0; i < readers.size(); i++) ok = ok && !readers[i]->failed();
+    for (size_t i = 0; i < excluded.size(); i++) ok = ok && !excluded[i]->failed();
+    ok = writer.close() && ok;
+    return ok ? (long long)writer.count() : -1;
+}
+
+// 把生成缓冲区排序去重后写成一个有序段
+static bool spillRun(PackedStateArray& buffer, ScratchFiles& scratch, vector<string>& runs,
+    size_t bufferRecords) {
+    buffer.sortUnique();
+
+    runs.push_back(scratch.create("R"));
+    StateRunWriter writer;
+    bool ok = writer.open(runs.back(), buffer.words(), bufferRecords);
+    for (size_t i = 0; ok && i < buffer.size(); i++) {
+        writer.write(buffer.record(i));
+    }
+    ok = writer.close() && ok;
+    scratch.setSize(runs.back(), (long long)buffer.size() * buffer.words() * sizeof(uint64_t));
+    buffer.clear();
+    return ok;
+}
+
+static bool externalBFS(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "BFS", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    ScratchFiles scratch(ctx.scratchDirectory);
+    PackedState shape;
+    shape.reset(startState.numTubes, startState.capacity);
+    size_t recordBytes = shape.words() * sizeof(uint64_t);
+
+    // 内存预算：归并时最多 归并路数 + 3 个读缓冲区和一个写缓冲区；
+    // 生成时只读当前层、写一个段，其余全部用作生成缓冲区
+    size_t budget = ctx.externalMemoryBytes;
+    if (ctx.memoryBudgetBytes > 0) budget = min(budget, (size_t)ctx.memoryBudgetBytes);
+    budget = max(budget, EXTERNAL_MIN_MEMORY);
+    size_t bufferRecords = max(EXTERNAL_MIN_BUFFER_RECORDS, budget / ((EXTERNAL_MERGE_FAN_IN + 4) * recordBytes));
+    size_t streamBytes = 2 * bufferRecords * recordBytes;
+    size_t maxMoves = (size_t)shape.numTubes * shape.numTubes;
+    // 生成缓冲区按稠密编码存放，多字编码排序时另需下标数组和一份排好的副本
+    size_t generateRecordBytes = shape.words() > 1 ? 2 * recordBytes + sizeof(uint32_t) : recordBytes;
+    size_t generateCapacity = max(4 * maxMoves, (budget > streamBytes ? budget - streamBytes : 0) / generateRecordBytes);
+
+    vector<string> layers;          // layers[d]：深度为 d 的全部状态（有序、无重复）
+    vector<long long> layerSizes;
+    string older;                   // layers[0 .. d-2] 的有序并集，为空表示还没有
+    string failure;                 // 读写失败的文件
+
+    PackedState goalKey = visitedKey(startState, ctx);
+    size_t goalDepth = 0;
+    layers.push_back(scratch.create("L"));
+    layerSizes.push_back(1);
+    {
+        StateRunWriter writer;
+        writer.open(layers[0], shape.words(), 1);
+        writer.write(goalKey);
+        if (!writer.close()) failure = layers[0];
+        scratch.setSize(layers[0], (long long)recordBytes);
+    }
+
+    StateMetrics startMetrics;
+    startMetrics.compute(startState);
+    bool found = startMetrics.isGoal(ctx.initialEmptyTubes);
+    MoveRecord noMove = { -1, 0, 0, 0, 0 };     // 层中没有上一步移动，撤销剪枝不生效
+    long long storedStates = 1;
+    PackedStateArray buffer;
+    buffer.reset(shape.numTubes, shape.capacity);
+    buffer.reserve(generateCapacity);
+    size_t peakBuffers = 0;
+
+    while (!found && failure.empty() && layerSizes.back() > 0) {
+        size_t depth = layers.size() - 1;
+        vector<string> runs;
+
+        // 生成下一层，生成时即做目标判定；缓冲区满时写出有序段
+        StateRunReader reader;
+        if (!reader.open(layers[depth], shape.numTubes, shape.capacity, bufferRecords)) failure = layers[depth];
+        for (; reader.valid() && !found && failure.empty(); reader.advance()) {
+            if (isCancelled(ctx)) {
+                ctx.cancelled = true;
+                break;
+            }
+            const PackedState& state = reader.state();
+            ctx.totalStatesExplored++;
+
+            StateMetrics metrics;
+            metrics.compute(state);
+            int firstEmpty = state.firstEmptyTube();
+            MoveIterator moves(state);
+            PourMove move;
+            while (moves.next(move)) {
+                if (isPrunedMove(ctx, state, move, noMove, firstEmpty)) continue;
+
+                PackedState child = state;
+                child.applyPour(move.from, move.to, move.amount);
+                StateMetrics childMetrics = metrics;
+                childMetrics.apply(state, move.from, move.to, move.amount);
+                if (childMetrics.isGoal(ctx.initialEmptyTubes)) {
+                    goalKey = visitedKey(child, ctx);
+                    goalDepth = layers.size();
+                    found = true;
+                    break;
+                }
+                buffer.push(visitedKey(child, ctx));
+            }
+            ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)buffer.size());
+            // 保证下一个状态的全部后继放得下，缓冲区不再扩容
+            if (buffer.size() + maxMoves > generateCapacity && !spillRun(buffer, scratch, runs, bufferRecords)) {
+                failure = runs.back();
+            }
+
+            reportProgress(ctx, "BFS", buffer.size());
+        }
+        if (reader.failed()) failure = layers[depth];
+        reader.close();
+        peakBuffers = max(peakBuffers, buffer.memoryBytes() / recordBytes * generateRecordBytes + streamBytes);   // 含排序时的临时空间
+        if (found || ctx.cancelled || !failure.empty()) break;
+        if (!buffer.empty() && !spillRun(buffer, scratch, runs, bufferRecords)) {
+            failure = runs.back();
+            break;
+        }
+
+        // 段数超过归并路数时先分批归并
+        size_t mergeBytes = 0;
+        while (runs.size() > (size_t)EXTERNAL_MERGE_FAN_IN && failure.empty()) {
+            vector<string> batch(runs.begin(), runs.begin() + EXTERNAL_MERGE_FAN_IN);
+            runs.erase(runs.begin(), runs.begin() + EXTERNAL_MERGE_FAN_IN);
+            string merged = scratch.create("R");
+            long long count = mergeRuns(batch, vector<string>(), merged, shape, bufferRecords, mergeBytes);
+            peakBuffers = max(peakBuffers, mergeBytes);
+            scratch.setSize(merged, count * (long long)recordBytes);
+            for (size_t i = 0; i < batch.size(); i++) scratch.release(batch[i]);
+            if (count < 0) failure = merged;
+            runs.push_back(merged);
+        }
+        if (!failure.empty()) break;
+
+        // 归并得到下一层：与前两层和更早各层归并相减
+        vector<string> exclude;
+        exclude.push_back(layers[depth]);
+        if (depth >= 1) exclude.push_back(layers[depth - 1]);
+        if (!older.empty()) exclude.push_back(older);
+        string next = scratch.create("L");
+        long long count = mergeRuns(runs, exclude, next, shape, bufferRecords, mergeBytes);
+        peakBuffers = max(peakBuffers, mergeBytes);
+        scratch.setSize(next, count * (long long)recordBytes);
+        for (size_t i = 0; i < runs.size(); i++) scratch.release(runs[i]);
+        if (count < 0) {
+            failure = next;
+            break;
+        }
+
+        // 上一层并入更早各层的并集（上一层文件仍保留，回溯时使用）
+        if (depth >= 1) {
+            vector<string> inputs(1, layers[depth - 1]);
+            if (!older.empty()) inputs.push_back(older);
+            string merged = scratch.create("U");
+            long long unionCount = mergeRuns(inputs, vector<string>(), merged, shape, bufferRecords, mergeBytes);
+            peakBuffers = max(peakBuffers, mergeBytes);
+            scratch.setSize(merged, unionCount * (long long)recordBytes);
+            if (!older.empty()) scratch.release(older);
+            older = merged;
+            if (unionCount < 0) {
+                failure = merged;
+                break;
+            }
+        }
+
+        storedStates += count;
+        layers.push_back(next);
+        layerSizes.push_back(count);
+    }
+
+    ctx.tableStats.size = (size_t)storedStates;
+    ctx.tableStats.capacity = (size_t)storedStates;
+    ctx.tableStats.loadFactor = 1.0;
+    ctx.tableStats.averageProbes = 0.0;
+    ctx.tableStats.maxProbes = 0;
+    ctx.tableStats.rehashCount = 0;
+    ctx.tableStats.memoryBytes = (size_t)scratch.peakBytes;
+    ctx.peakMemoryBytes = (long long)peakBuffers;
+    ctx.externalDiskBytes = scratch.peakBytes;
+
+    if (found) {
+        // 逐层顺序扫描回溯去重键序列
+        vector<PackedState> keys(goalDepth + 1);
+        vector<PourMove> keyMoves(goalDepth);
+        keys[goalDepth] = goalKey;
+        for (size_t d = goalDepth; d > 0 && failure.empty(); d--) {
+            StateRunReader reader;
+            reader.open(layers[d - 1], shape.numTubes, shape.capacity, bufferRecords);
+            for (; reader.valid(); reader.advance()) {
+                if (findMoveTo(reader.state(), keys[d], ctx, keyMoves[d - 1])) {
+                    keys[d - 1] = reader.state();
+                    break;
+                }
+            }
+            if (reader.failed()) failure = layers[d - 1];
+        }
+        if (failure.empty()) {
+            vector<MoveRecord> moves;
+            keyPathToMoves(startState, keys, keyMoves, moves);
+            replayMoves(start, moves, ctx.solutionPath);
+        }
+        else {
+            found = false;
+        }
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    if (!failure.empty()) {
+        ctx.noSolutionReason = "外存 BFS 读写临时文件失败（搜索未完成，不能据此判定无解）: " + failure;
+    }
+    recordStats(ctx, "BFS", found);
+    if (!failure.empty()) ctx.stats.solutionStatus = "出错";
+    return found;
+}
+
+// ==================== 并行 BFS ====================
+// 按层同步：每层的待扩展数组按块分给工作线程，线程用原子下标领取块；去重使用分片加锁的已访问表。
+// 新节点先记在线程自己的缓冲区，层结束后由主线程按线程顺序追加到搜索树，搜索树仍只有一个线程写。
+// 目标在生成时判定，第一个出现目标的层即最短步数，与串行 BFS 报告的步数相同。
+
+struct ParallelEntry {
+    PackedState state;
+    MoveRecord lastMove;    // 到达该状态的移动，parent 为父节点下标
+    int node;               // 搜索树节点下标，层结束合并时才分配
+};
+
+// 一个工作线程在一层中的结果
+struct ParallelWorkerResult {
+    vector<ParallelEntry> children;
+    long long prunedByRule[PRUNE_RULE_COUNT];
+    int explored;
+    int goalIndex;          // children 中目标状态的下标，-1 表示没有
+    long long busyMicros;   // 本层中实际工作的时间
+};
+
+// 解析线程数设置：0 或负数表示全部核心
+static int resolveThreadCount(int requested) {
+    int count = requested > 0 ? requested : (int)thread::hardware_concurrency();
+    return count > 0 ? count : 1;
+}
+
+static bool parallelBFS(const GameState& start, SolverContext& ctx, int threadCount) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "BFS", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    ShardedStateTable<char> visited(ctx.expectedStates);
+    SearchTree tree;  // 只由主线程在层间写入
+    bool inserted;
+
+    vector<ParallelEntry> current;
+    int rootNode = tree.addRoot();
+    ParallelEntry root = { startState, tree[rootNode], rootNode };
+    current.push_back(root);
+    visited.insertOrFind(visitedKey(startState, ctx), 1, inserted);
+
+    int goalNode = -1;
+    StateMetrics startMetrics;
+    startMetrics.compute(startState);
+    if (startMetrics.isGoal(ctx.initialEmptyTubes)) goalNode = rootNode;
+
+    vector<ParallelWorkerResult> results(threadCount);
+    long long busyMicros = 0;
+    const size_t CHUNK_SIZE = 64;
+
+    while (goalNode < 0 && !current.empty()) {
+        if (isCancelled(ctx)) {
+            ctx.cancelled = true;
+            break;
+        }
+        // 层间检查内存并可压缩；层内各线程只按自己的新状态缓冲区估计本层增长
+        auto layerBytes = [&]() {
+            return (long long)(tree.bytesReserved() + visited.stats().memoryBytes + current.capacity() * sizeof(ParallelEntry));
+        };
+        if (overMemoryBudget(ctx, layerBytes, [&]() {
+                visited.compact();
+                current.shrink_to_fit();
+            })) {
+            break;
+        }
+        long long layerBase = ctx.memoryBudgetBytes > 0 ? layerBytes() : 0;
+        atomic<size_t> nextChunk(0);
+        atomic<bool> goalFound(false);
+        atomic<bool> memoryStop(false);
+
+        auto worker = [&](int id) {
+            auto workerStart = high_resolution_clock::now();
+            ParallelWorkerResult& result = results[id];
+            result.children.clear();
+            result.explored = 0;
+            result.goalIndex = -1;
+            for (int i = 0; i < PRUNE_RULE_COUNT; i++) result.prunedByRule[i] = 0;
+
+            while (result.goalIndex < 0 && !goalFound.load(memory_order_relaxed) && !isCancelled(ctx) &&
+                !memoryStop.load(memory_order_relaxed)) {
+                if (ctx.memoryBudgetBytes > 0 && layerBase + (long long)(result.children.capacity() *
+                    sizeof(ParallelEntry)) * threadCount > ctx.memoryBudgetBytes) {
+                    memoryStop.store(true);
+                    break;
+                }
+                size_t begin = nextChunk.fetch_add(CHUNK_SIZE);
+                if (begin >= current.size()) break;
+                size_t end = min(begin + CHUNK_SIZE, current.size());
+
+                for (size_t i = begin; i < end && result.goalIndex < 0; i++) {
+                    const ParallelEntry& entry = current[i];
+                    result.explored++;
+
+                    StateMetrics metrics;
+                    metrics.compute(entry.state);
+                    int firstEmpty = entry.state.firstEmptyTube();
+                    MoveIterator moves(entry.state);
+                    PourMove move;
+                    while (moves.next(move)) {
+                        if (isPrunedMove(ctx.pruneRules, result.prunedByRule, entry.state, move,
+                            entry.lastMove, firstEmpty)) continue;
+
+                        MoveRecord record = { entry.node, (uint8_t)move.from, (uint8_t)move.to, (uint8_t)move.amount, 0 };
+                        ParallelEntry child = { entry.state, record, -1 };
+                        child.state.applyPour(move.from, move.to, move.amount);
+
+                        bool isNew;
+                        visited.insertOrFind(visitedKey(child.state, ctx), 1, isNew);
+                        if (!isNew) continue;
+                        result.children.push_back(child);
+
+                        StateMetrics childMetrics = metrics;
+                        childMetrics.apply(entry.state, move.from, move.to, move.amount);
+                        if (childMetrics.isGoal(ctx.initialEmptyTubes)) {
+                            result.goalIndex = (int)result.children.size() - 1;
+                            goalFound.store(true, memory_order_relaxed);
+                            break;
+                        }
+                    }
+                }
+            }
+
+            result.busyMicros = duration_cast<microseconds>(high_resolution_clock::now() - workerStart).count();
+        };
+
+        vector<thread> workers;
+        for (int id = 0; id < threadCount; id++) {
+            workers.push_back(thread(worker, id));
+        }
+        for (auto& t : workers) {
+            t.join();
+        }
+        if (memoryStop.load()) {
+            for (int id = 0; id < threadCount; id++) ctx.totalStatesExplored += results[id].explored;
+            ctx.memoryActionTaken = MEMORY_ABORT;
+            break;
+        }
+
+        // 合并各线程结果：按线程顺序分配节点下标，组成下一层
+        vector<ParallelEntry> next;
+        for (int id = 0; id < threadCount; id++) {
+            ParallelWorkerResult& result = results[id];
+            ctx.totalStatesExplored += result.explored;
+            busyMicros += result.busyMicros;
+            for (int i = 0; i < PRUNE_RULE_COUNT; i++) ctx.prunedByRule[i] += result.prunedByRule[i];
+
+            for (size_t i = 0; i < result.children.size(); i++) {
+                ParallelEntry& child = result.children[i];
+                child.node = tree.addChild(child.lastMove.parent, child.lastMove.from, child.lastMove.to,
+                    child.lastMove.amount);
+                if (goalNode < 0 && (int)i == result.goalIndex) goalNode = child.node;
+                next.push_back(child);
+            }
+            result.children.clear();
+        }
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)(current.size() + next.size()));
+        current.swap(next);
+
+        publishProgress(ctx, "BFS", ctx.totalStatesExplored, current.size());
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+    long long wallMicros = duration_cast<microseconds>(endTime - startTime).count();
+    ctx.threadsUsed = threadCount;
+    ctx.parallelSpeedup = wallMicros > 0 ? (double)busyMicros / wallMicros : 1.0;
+
+    ctx.tableStats = visited.stats();
+    ctx.peakMemoryBytes = (long long)(tree.bytesReserved() + ctx.tableStats.memoryBytes +
+        ctx.maxStatesInMemory * sizeof(ParallelEntry));
+    if (goalNode >= 0) {
+        replayMoves(start, tree.extractMoves(goalNode), ctx.solutionPath);
+    }
+    recordStats(ctx, "BFS", goalNode >= 0);
+    return goalNode >= 0;
+}
+
+// 串行 BFS；设置了 layeredBFS 时改用分层批量去重，searchThreads 大于1时改用并行 BFS
+bool BFS_Solve(const GameState& start, SolverContext& ctx) {
+    if (ctx.externalBFS) return externalBFS(start, ctx);
+    if (ctx.layeredBFS) return layeredBFS(start, ctx);
+    int threadCount = resolveThreadCount(ctx.searchThreads);
+    if (threadCount > 1) return parallelBFS(start, ctx, threadCount);
+
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "BFS", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    queue<FrontierEntry> q;
+    StateTable<char> visited(ctx.expectedStates);
+    SearchTree tree;  // 本次求解的全部节点，函数返回时整体释放
+    bool inserted;
+
+    FrontierEntry root = { startState, StateMetrics(), tree.addRoot(), 0 };
+    root.metrics.compute(startState);
+    q.push(root);
+    visited.insertOrFind(visitedKey(startState, ctx), 1, inserted);
+
+    int goalNode = -1;
+
+    while (!q.empty()) {
+        if (isCancelled(ctx)) {
+            ctx.cancelled = true;
+            break;
+        }
+        if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                return (long long)(tree.bytesReserved() + visited.stats().memoryBytes + q.size() * sizeof(FrontierEntry));
+            }, [&]() { visited.compact(); })) {
+            break;
+        }
+        int currentQueueSize = (int)q.size();
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, currentQueueSize);
+
+        FrontierEntry current = q.front();
+        q.pop();
+        ctx.totalStatesExplored++;
+
+        if (current.metrics.isGoal(ctx.initialEmptyTubes)) {
+            goalNode = current.node;
+            break;
+        }
+
+        MoveRecord lastMove = tree[current.node];
+        int firstEmpty = current.state.firstEmptyTube();
+        MoveIterator moves(current.state);
+        PourMove move;
+        while (moves.next(move)) {
+            if (isPrunedMove(ctx, current.state, move, lastMove, firstEmpty)) continue;
+
+            FrontierEntry next = { current.state, current.metrics, 0, current.gCost + 1 };
+            next.metrics.apply(current.state, move.from, move.to, move.amount);
+            next.state.applyPour(move.from, move.to, move.amount);
+
+            visited.insertOrFind(visitedKey(next.state, ctx), 1, inserted);
+            if (inserted) {
+                next.node = tree.addChild(current.node, move.from, move.to, move.amount);
+                q.push(next);
+            }
+        }
+
+        reportProgress(ctx, "BFS", q.size());
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats = visited.stats();
+    ctx.peakMemoryBytes = (long long)(tree.bytesReserved() + ctx.tableStats.memoryBytes +
+        ctx.maxStatesInMemory * sizeof(FrontierEntry));
+    if (goalNode >= 0) {
+        replayMoves(start, tree.extractMoves(goalNode), ctx.solutionPath);
+    }
+    recordStats(ctx, "BFS", goalNode >= 0);
+    return goalNode >= 0;
+}
+
+bool DFS_Solve(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "DFS", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    stack<FrontierEntry> s;
+    StateTable<char> visited(ctx.expectedStates);
+    SearchTree tree;  // 本次求解的全部节点，函数返回时整体释放
+    bool inserted;
+
+    FrontierEntry root = { startState, StateMetrics(), tree.addRoot(), 0 };
+    root.metrics.compute(startState);
+    s.push(root);
+    visited.insertOrFind(visitedKey(startState, ctx), 1, inserted);
+
+    int goalNode = -1;
+    int minSteps = INT_MAX;
+
+    while (!s.empty()) {
+        if (isCancelled(ctx)) {
+            ctx.cancelled = true;
+            break;
+        }
+        if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                return (long long)(tree.bytesReserved() + visited.stats().memoryBytes + s.size() * sizeof(FrontierEntry));
+            }, [&]() { visited.compact(); })) {
+            break;
+        }
+        int currentStackSize = (int)s.size();
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, currentStackSize);
+
+        FrontierEntry current = s.top();
+        s.pop();
+        ctx.totalStatesExplored++;
+
+        if (current.metrics.isGoal(ctx.initialEmptyTubes)) {
+            // DFS不一定找到最短路径，记录找到的第一个解
+            if (goalNode < 0 || current.gCost < minSteps) {
+                goalNode = current.node;
+                minSteps = current.gCost;
+            }
+            continue;  // 继续搜索可能找到更短路径
+        }
+
+        MoveRecord lastMove = tree[current.node];
+        int firstEmpty = current.state.firstEmptyTube();
+        MoveIterator moves(current.state);
+        PourMove move;
+        while (moves.next(move)) {
+            if (isPrunedMove(ctx, current.state, move, lastMove, firstEmpty)) continue;
+
+            FrontierEntry next = { current.state, current.metrics, 0, current.gCost + 1 };
+            next.metrics.apply(current.state, move.from, move.to, move.amount);
+            next.state.applyPour(move.from, move.to, move.amount);
+
+            visited.insertOrFind(visitedKey(next.state, ctx), 1, inserted);
+            if (inserted) {
+                next.node = tree.addChild(current.node, move.from, move.to, move.amount);
+                s.push(next);
+            }
+        }
+
+        reportProgress(ctx, "DFS", s.size());
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats = visited.stats();
+    ctx.peakMemoryBytes = (long long)(tree.bytesReserved() + ctx.tableStats.memoryBytes +
+        ctx.maxStatesInMemory * sizeof(FrontierEntry));
+    if (goalNode >= 0) {
+        replayMoves(start, tree.extractMoves(goalNode), ctx.solutionPath);
+    }
+    recordStats(ctx, "DFS", goalNode >= 0);
+    return goalNode >= 0;
+}
+
+// A*开放表中的状态及其增量统计
+struct OpenState {
+    PackedState state;
+    StateMetrics metrics;
+};
+
+// A*开放表条目：堆中只放小条目，状态存放在可复用的槽位中
+struct AStarEntry {
+    int gCost;
+    int hCost;
+    int node;       // 搜索树节点下标
+    int slot;       // openStates 中的槽位
+};
+
+// A*算法比较结构体
+struct AStarCompare {
+    bool operator()(const AStarEntry& a, const AStarEntry& b) const {
+        // 首先比较f值，如果相同则比较h值
+        int f1 = a.gCost + a.hCost;
+        int f2 = b.gCost + b.hCost;
+        if (f1 != f2) return f1 > f2;
+        return a.hCost > b.hCost;  // 倾向于h值更小的状态
+    }
+};
+
+// ==================== 并行 A*（HDA*） ====================
+// 按去重键的哈希把状态空间分给各线程：每个线程只展开自己拥有的状态，各有自己的开放表和已访问表。
+// 生成的后继发给拥有它的线程：发送方按目标线程缓冲成批，再以无锁栈压入对方收件箱，
+// 收件方一次取走整个栈（exchange），因此没有 ABA 问题。
+// 找到目标只更新当前最优解 incumbent，不立即停止；各线程只展开 f 小于 incumbent 的状态。
+// 终止判定用一个计数 pending = 在途消息数 + 活跃线程数：发送前先加上消息数；线程取到消息时
+// 先计入自己再减去消息数；转为空闲前先发出全部缓冲的消息再减去自己。只要还有工作 pending 就不为0，
+// pending 为0时所有开放表中的 f 都不小于 incumbent，启发函数可采纳，incumbent 即最优解。
+// 搜索树节点放在各线程自己的节点池中，节点编号高位为线程号，父节点可以属于其他线程。
+
+const int HDA_NODE_BITS = 40;
+const int64_t HDA_NODE_MASK = ((int64_t)1 << HDA_NODE_BITS) - 1;
+
+struct HDAMessage {
+    PackedState state;
+    int64_t parent;         // 父节点编号（线程号 << HDA_NODE_BITS | 池内下标）
+    int gCost;
+    uint8_t from;
+    uint8_t to;
+    uint8_t amount;
+};
+
+// 收件箱中的一批消息，收件箱是这些批次组成的无锁栈
+struct HDABatch {
+    vector<HDAMessage> messages;
+    HDABatch* next;
+};
+
+// 搜索树节点：与 MoveRecord 相同，只是父节点编号需要带上线程号
+struct HDANode {
+    int64_t parent;         // -1 表示根节点
+    uint8_t from;
+    uint8_t to;
+    uint8_t amount;
+    uint8_t reserved;
+};
+
+struct HDAOpenEntry {
+    PackedState state;
+    StateMetrics metrics;
+    int gCost;
+    int hCost;
+    int64_t node;
+};
+
+struct HDACompare {
+    bool operator()(const HDAOpenEntry& a, const HDAOpenEntry& b) const {
+        int f1 = a.gCost + a.hCost;
+        int f2 = b.gCost + b.hCost;
+        if (f1 != f2) return f1 > f2;
+        return a.hCost > b.hCost;
+    }
+};
+
+// 一个工作线程的数据；收件箱和展开计数会被其他线程访问，其余只在本线程内使用，结束后由主线程汇总
+struct HDAWorker {
+    atomic<HDABatch*> inbox;
+    atomic<int> explored;
+    atomic<int> openSize;       // 开放表当前长度，仅供进度显示
+    NodeArena<HDANode> nodes;
+    StateTableStats tableStats;
+    long long prunedByRule[PRUNE_RULE_COUNT];
+    int maxOpen;
+    long long busyMicros;
+
+    HDAWorker() : inbox(NULL), explored(0), openSize(0), maxOpen(0), busyMicros(0) {
+        tableStats = { 0, 0, 0.0, 0.0, 0, 0, 0 };
+        for (int i = 0; i < PRUNE_RULE_COUNT; i++) prunedByRule[i] = 0;
+    }
+};
+
+// 状态的拥有者线程：取哈希高位，与表内定位槽位用的低位互不相关
+static inline int hdaOwner(const PackedState& key, int threadCount) {
+    return (int)(((key.hash() >> 32) * (uint64_t)threadCount) >> 32);
+}
+
+// 不依赖父状态计算启发值；分配启发函数的矩阵按状态重建（HDA* 的消息与 ARA* 的状态表都不携带矩阵）
+static int rebuiltHeuristic(const PackedState& state, const StateMetrics& metrics, int heuristic) {
+    if (heuristic != HEURISTIC_ASSIGNMENT) return metrics.heuristic(heuristic);
+    AssignmentMatrix matrix;
+    matrix.build(state, metrics);
+    return matrix.bound(metrics);
+}
+
+static bool hdaStar(const GameState& start, SolverContext& ctx, int threadCount) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "A*", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    vector<unique_ptr<HDAWorker>> workers;
+    for (int id = 0; id < threadCount; id++) {
+        workers.push_back(unique_ptr<HDAWorker>(new HDAWorker()));
+    }
+
+    atomic<long long> pending(1);           // 在途消息数 + 活跃线程数，初始为根状态这一条消息
+    atomic<int> incumbentCost(INT_MAX);     // 当前最优解步数
+    int64_t goalNode = -1;
+    mutex incumbentLock;                    // 保护 incumbentCost 与 goalNode 的同时更新
+    atomic<bool> memoryStop(false);         // 某个线程超出了它的内存份额
+    atomic<bool> memoryCompacted(false);
+
+    HDABatch* rootBatch = new HDABatch();
+    HDAMessage rootMessage = { startState, -1, 0, 0, 0, 0 };
+    rootBatch->messages.push_back(rootMessage);
+    rootBatch->next = NULL;
+    workers[hdaOwner(visitedKey(startState, ctx), threadCount)]->inbox.store(rootBatch);
+
+    const size_t BATCH_SIZE = 32;       // 发往同一线程的消息攒够这么多就发出
+    const int FLUSH_INTERVAL = 64;      // 每展开这么多状态发出全部缓冲，避免其他线程空等
+
+    auto run = [&](int id) {
+        HDAWorker& self = *workers[id];
+        priority_queue<HDAOpenEntry, vector<HDAOpenEntry>, HDACompare> open;
+        StateTable<int> closed(ctx.expectedStates / threadCount);  // 本线程拥有的状态的最小 gCost
+        vector<HDABatch*> outgoing(threadCount, (HDABatch*)NULL);
+        bool active = false;
+        int sinceFlush = 0;
+        auto runStart = high_resolution_clock::now();
+        auto idleSince = runStart;
+        long long idleMicros = 0;
+        bool compacted = false;
+
+        auto flush = [&](int to) {
+            HDABatch* batch = outgoing[to];
+            if (batch == NULL) return;
+            outgoing[to] = NULL;
+            pending.fetch_add((long long)batch->messages.size());
+            HDABatch* head = workers[to]->inbox.load(memory_order_relaxed);
+            do {
+                batch->next = head;
+            } while (!workers[to]->inbox.compare_exchange_weak(head, batch, memory_order_release, memory_order_relaxed));
+        };
+
+        // 取走收件箱中的全部消息，改进了已知代价的状态进入开放表；返回收到的消息数
+        auto receive = [&]() -> long long {
+            HDABatch* batch = self.inbox.exchange(NULL, memory_order_acquire);
+            long long received = 0;
+            while (batch != NULL) {
+                for (const HDAMessage& message : batch->messages) {
+                    received++;
+                    if (message.gCost >= incumbentCost.load(memory_order_relaxed)) continue;
+
+                    bool inserted;
+                    int* bestGCost = closed.insertOrFind(visitedKey(message.state, ctx), message.gCost, inserted);
+                    if (!inserted && *bestGCost <= message.gCost) continue;
+                    *bestGCost = message.gCost;
+
+                    HDAOpenEntry entry;
+                    entry.state = message.state;
+                    entry.metrics.compute(message.state);
+                    entry.gCost = message.gCost;
+                    entry.node = ((int64_t)id << HDA_NODE_BITS) | (int64_t)self.nodes.size();
+                    HDANode* record = self.nodes.allocate();
+                    record->parent = message.parent;
+                    record->from = message.from;
+                    record->to = message.to;
+                    record->amount = message.amount;
+
+                    if (entry.metrics.isGoal(ctx.initialEmptyTubes)) {
+                        lock_guard<mutex> guard(incumbentLock);
+                        if (entry.gCost < incumbentCost.load(memory_order_relaxed)) {
+                            incumbentCost.store(entry.gCost);
+                            goalNode = entry.node;
+                        }
+                        continue;
+                    }
+
+                    entry.hCost = weightedHeuristic(rebuiltHeuristic(entry.state, entry.metrics, ctx.heuristic), ctx);
+                    if (entry.gCost + entry.hCost >= incumbentCost.load(memory_order_relaxed)) continue;
+                    open.push(entry);
+                }
+                HDABatch* next = batch->next;
+                delete batch;
+                batch = next;
+            }
+            return received;
+        };
+
+        while (!isCancelled(ctx) && !memoryStop.load(memory_order_relaxed)) {
+            long long received = receive();
+            if (received > 0) {
+                if (!active) {
+                    active = true;
+                    idleMicros += duration_cast<microseconds>(high_resolution_clock::now() - idleSince).count();
+                    pending.fetch_add(1 - received);
+                }
+                else {
+                    pending.fetch_sub(received);
+                }
+            }
+
+            // 跳过已被更短路径取代的条目
+            while (!open.empty() && *closed.find(visitedKey(open.top().state, ctx)) < open.top().gCost) {
+                open.pop();
+            }
+
+            if (!open.empty() && open.top().gCost + open.top().hCost < incumbentCost.load(memory_order_relaxed)) {
+                HDAOpenEntry current = open.top();
+                open.pop();
+                int explored = self.explored.load(memory_order_relaxed) + 1;
+                self.explored.store(explored, memory_order_relaxed);
+
+                // 各线程按预算的 1/threadCount 检查自己的节点池、已访问表与开放表
+                if (ctx.memoryBudgetBytes > 0 && explored % MEMORY_CHECK_INTERVAL == 0) {
+                    auto measure = [&]() {
+                        return (long long)(self.nodes.bytesReserved() + closed.stats().memoryBytes +
+                            open.size() * sizeof(HDAOpenEntry)) * threadCount;
+                    };
+                    if (measure() > ctx.memoryBudgetBytes && ctx.memoryAction == MEMORY_COMPACT && !compacted) {
+                        compacted = true;
+                        closed.compact();
+                        memoryCompacted.store(true);
+                    }
+                    if (measure() > ctx.memoryBudgetBytes) memoryStop.store(true);
+                }
+
+                const HDANode& record = self.nodes[(size_t)(current.node & HDA_NODE_MASK)];
+                MoveRecord lastMove = { record.parent >= 0 ? 0 : -1, record.from, record.to, record.amount, 0 };
+                int firstEmpty = current.state.firstEmptyTube();
+                MoveIterator moves(current.state);
+                PourMove move;
+                while (moves.next(move)) {
+                    if (isPrunedMove(ctx.pruneRules, self.prunedByRule, current.state, move, lastMove, firstEmpty)) continue;
+
+                    HDAMessage message = { current.state, current.node, current.gCost + 1,
+                        (uint8_t)move.from, (uint8_t)move.to, (uint8_t)move.amount };
+                    message.state.applyPour(move.from, move.to, move.amount);
+
+                    int to = hdaOwner(visitedKey(message.state, ctx), threadCount);
+                    if (outgoing[to] == NULL) {
+                        outgoing[to] = new HDABatch();
+                        outgoing[to]->messages.reserve(BATCH_SIZE);
+                    }
+                    outgoing[to]->messages.push_back(message);
+                    if (outgoing[to]->messages.size() >= BATCH_SIZE) flush(to);
+                }
+                self.maxOpen = max(self.maxOpen, (int)open.size());
+                self.openSize.store((int)open.size(), memory_order_relaxed);
+
+                if (++sinceFlush >= FLUSH_INTERVAL) {
+                    for (int to = 0; to < threadCount; to++) flush(to);
+                    sinceFlush = 0;
+                }
+                continue;
+            }
+
+            // 没有可改进当前解的状态：发出缓冲的消息后转为空闲，等待新消息或全局终止
+            for (int to = 0; to < threadCount; to++) flush(to);
+            sinceFlush = 0;
+            if (active) {
+                active = false;
+                idleSince = high_resolution_clock::now();
+                pending.fetch_sub(1);
+            }
+            if (pending.load() == 0) break;
+            this_thread::yield();
+        }
+
+        for (int to = 0; to < threadCount; to++) delete outgoing[to];  // 取消时可能还有未发出的消息
+
+        auto runEnd = high_resolution_clock::now();
+        if (!active) idleMicros += duration_cast<microseconds>(runEnd - idleSince).count();
+        self.busyMicros = duration_cast<microseconds>(runEnd - runStart).count() - idleMicros;
+        self.tableStats = closed.stats();
+    };
+
+    vector<thread> threads;
+    for (int id = 0; id < threadCount; id++) {
+        threads.push_back(thread(run, id));
+    }
+    // 进度回调不一定线程安全，只由主线程定时调用
+    if (ctx.onProgress || ctx.progressChannel != NULL) {
+        while (pending.load() != 0 && !isCancelled(ctx) && !memoryStop.load()) {
+            this_thread::sleep_for(milliseconds(100));
+            int explored = 0;
+            size_t frontier = 0;
+            for (int id = 0; id < threadCount; id++) {
+                explored += workers[id]->explored.load(memory_order_relaxed);
+                frontier += workers[id]->openSize.load(memory_order_relaxed);
+            }
+            publishProgress(ctx, "A*", explored, frontier);
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    // 取消时收件箱中可能还有消息
+    for (int id = 0; id < threadCount; id++) {
+        HDABatch* batch = workers[id]->inbox.exchange(NULL);
+        while (batch != NULL) {
+            HDABatch* next = batch->next;
+            delete batch;
+            batch = next;
+        }
+    }
+    bool stopped = pending.load() != 0;
+    ctx.cancelled = stopped && !memoryStop.load();
+    if (memoryStop.load()) ctx.memoryActionTaken = MEMORY_ABORT;
+    else if (memoryCompacted.load()) ctx.memoryActionTaken = MEMORY_COMPACT;
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+    long long wallMicros = duration_cast<microseconds>(endTime - startTime).count();
+
+    // 汇总各线程统计；已访问表按各线程表合计，平均探测数按表大小加权
+    long long busyMicros = 0;
+    size_t nodeBytes = 0;
+    double probeSum = 0.0;
+    ctx.tableStats = { 0, 0, 0.0, 0.0, 0, 0, 0 };
+    for (int id = 0; id < threadCount; id++) {
+        HDAWorker& worker = *workers[id];
+        ctx.totalStatesExplored += worker.explored.load();
+        ctx.maxStatesInMemory += worker.maxOpen;
+        busyMicros += worker.busyMicros;
+        nodeBytes += worker.nodes.bytesReserved();
+        for (int i = 0; i < PRUNE_RULE_COUNT; i++) ctx.prunedByRule[i] += worker.prunedByRule[i];
+
+        const StateTableStats& s = worker.tableStats;
+        ctx.tableStats.size += s.size;
+        ctx.tableStats.capacity += s.capacity;
+        ctx.tableStats.memoryBytes += s.memoryBytes;
+        ctx.tableStats.rehashCount += s.rehashCount;
+        ctx.tableStats.maxProbes = max(ctx.tableStats.maxProbes, s.maxProbes);
+        probeSum += s.averageProbes * s.size;
+    }
+    if (ctx.tableStats.capacity > 0) ctx.tableStats.loadFactor = (double)ctx.tableStats.size / ctx.tableStats.capacity;
+    if (ctx.tableStats.size > 0) ctx.tableStats.averageProbes = probeSum / ctx.tableStats.size;
+    ctx.threadsUsed = threadCount;
+    ctx.parallelSpeedup = wallMicros > 0 ? (double)busyMicros / wallMicros : 1.0;
+    ctx.peakMemoryBytes = (long long)(nodeBytes + ctx.tableStats.memoryBytes +
+        ctx.maxStatesInMemory * sizeof(HDAOpenEntry));
+
+    bool found = goalNode >= 0 && !stopped;  // 取消或超出内存时当前解未经证明最优，不采用
+    if (found) {
+        vector<MoveRecord> moves;
+        int64_t node = goalNode;
+        while (true) {
+            const HDANode& record = workers[(size_t)(node >> HDA_NODE_BITS)]->nodes[(size_t)(node & HDA_NODE_MASK)];
+            if (record.parent < 0) break;
+            MoveRecord move = { 0, record.from, record.to, record.amount, 0 };
+            moves.push_back(move);
+            node = record.parent;
+        }
+        reverse(moves.begin(), moves.end());
+        replayMoves(start, moves, ctx.solutionPath);
+    }
+    recordStats(ctx, "A*", found);
+    return found;
+}
+
+// 串行 A*；searchThreads 大于1时改用 HDA*
+bool AStar_Solve(const GameState& start, SolverContext& ctx) {
+    int threadCount = resolveThreadCount(ctx.searchThreads);
+    if (threadCount > 1) return hdaStar(start, ctx, threadCount);
+
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "A*", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    priority_queue<AStarEntry, vector<AStarEntry>, AStarCompare> pq;
+    vector<OpenState> openStates;     // 开放表中各条目的状态
+    vector<int> freeSlots;            // 已出队、可复用的槽位
+    vector<AssignmentMatrix> openMatrices;  // 分配启发函数的代价矩阵缓存，与 openStates 同槽位
+    bool useAssignment = ctx.heuristic == HEURISTIC_ASSIGNMENT;
+    StateTable<int> visited(ctx.expectedStates);  // 记录每个状态的最小gCost
+    SearchTree tree;  // 本次求解的全部节点，函数返回时整体释放
+    bool inserted;
+
+    OpenState startOpen = { startState, StateMetrics() };
+    startOpen.metrics.compute(startState);
+    openStates.push_back(startOpen);
+    AStarEntry root = { 0, weightedHeuristic(startOpen.metrics.heuristic(ctx.heuristic), ctx), tree.addRoot(), 0 };
+    if (useAssignment) {
+        openMatrices.push_back(AssignmentMatrix());
+        openMatrices[0].build(startState, startOpen.metrics);
+        root.hCost = weightedHeuristic(openMatrices[0].bound(startOpen.metrics), ctx);
+    }
+    pq.push(root);
+    visited.insertOrFind(visitedKey(startState, ctx), 0, inserted);
+
+    int goalNode = -1;
+
+    while (!pq.empty()) {
+        if (isCancelled(ctx)) {
+            ctx.cancelled = true;
+            break;
+        }
+        if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                return (long long)(tree.bytesReserved() + visited.stats().memoryBytes +
+                    openStates.capacity() * sizeof(OpenState) + openMatrices.capacity() * sizeof(AssignmentMatrix) +
+                    pq.size() * sizeof(AStarEntry));
+            }, [&]() {
+                visited.compact();
+                openStates.shrink_to_fit();
+                openMatrices.shrink_to_fit();
+            })) {
+            break;
+        }
+        int currentQueueSize = (int)pq.size();
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, currentQueueSize);
+
+        AStarEntry current = pq.top();
+        pq.pop();
+        OpenState currentOpen = openStates[current.slot];
+        const PackedState& currentState = currentOpen.state;
+        AssignmentMatrix currentMatrix;
+        if (useAssignment) currentMatrix = openMatrices[current.slot];  // 槽位随后会被子状态复用
+        freeSlots.push_back(current.slot);
+        ctx.totalStatesExplored++;
+
+        // 验证当前状态是否是最优路径上的（不是被更优路径取代的）
+        if (*visited.find(visitedKey(currentState, ctx)) < current.gCost) {
+            continue;
+        }
+
+        if (currentOpen.metrics.isGoal(ctx.initialEmptyTubes)) {
+            goalNode = current.node;
+            break;
+        }
+
+        MoveRecord lastMove = tree[current.node];
+        int firstEmpty = currentState.firstEmptyTube();
+        MoveIterator moves(currentState);
+        PourMove move;
+        while (moves.next(move)) {
+            if (isPrunedMove(ctx, currentState, move, lastMove, firstEmpty)) continue;
+
+            OpenState next = currentOpen;
+            next.metrics.apply(currentState, move.from, move.to, move.amount);
+            next.state.applyPour(move.from, move.to, move.amount);
+
+            int newGCost = current.gCost + 1;
+            int* bestGCost = visited.insertOrFind(visitedKey(next.state, ctx), newGCost, inserted);
+            if (inserted || newGCost < *bestGCost) {
+                *bestGCost = newGCost;
+
+                AStarEntry entry;
+                entry.gCost = newGCost;
+                entry.hCost = weightedHeuristic(next.metrics.heuristic(ctx.heuristic), ctx);
+                entry.node = tree.addChild(current.node, move.from, move.to, move.amount);
+                if (!freeSlots.empty()) {
+                    entry.slot = freeSlots.back();
+                    freeSlots.pop_back();
+                    openStates[entry.slot] = next;
+                }
+                else {
+                    entry.slot = (int)openStates.size();
+                    openStates.push_back(next);
+                    if (useAssignment) openMatrices.push_back(AssignmentMatrix());
+                }
+                if (useAssignment) {
+                    AssignmentMatrix& matrix = openMatrices[entry.slot];
+                    matrix = currentMatrix;
+                    matrix.applyPour(next.state, next.metrics, move.from, move.to);
+                    entry.hCost = weightedHeuristic(matrix.bound(next.metrics), ctx);
+                }
+                pq.push(entry);
+            }
+        }
+
+        reportProgress(ctx, "A*", pq.size());
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats = visited.stats();
+    ctx.peakMemoryBytes = (long long)(tree.bytesReserved() + ctx.tableStats.memoryBytes +
+        openStates.capacity() * sizeof(OpenState) +
+        openMatrices.capacity() * sizeof(AssignmentMatrix) + ctx.maxStatesInMemory * sizeof(AStarEntry));
+    if (goalNode >= 0) {
+        replayMoves(start, tree.extractMoves(goalNode), ctx.solutionPath);
+    }
+    recordStats(ctx, "A*", goalNode >= 0);
+    return goalNode >= 0;
+}
+
+// IDA*当前路径上的一层：状态、启发信息，以及该层尚未尝试的移动
+struct IDAFrame {
+    PackedState state;
+    StateMetrics metrics;
+    AssignmentMatrix matrix;    // 仅在使用分配启发函数时维护
+    MoveIterator moves;
+    MoveRecord lastMove;        // 到达本层的移动（根的 parent 为 -1）
+    int firstEmpty;
+};
+
+bool IDAStar_Solve(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "IDA*", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    // 有内存预算时置换表不超过预算的一半，其余留给当前路径
+    size_t tableBytes = ctx.transpositionBytes;
+    if (ctx.memoryBudgetBytes > 0) tableBytes = min(tableBytes, (size_t)(ctx.memoryBudgetBytes / 2));
+    TranspositionTable table(tableBytes, ctx.transpositionPolicy, startState.words());
+    DeadStateCache dead(DEAD_CACHE_STATES);     // 各轮共用
+    vector<IDAFrame> path;
+    bool useAssignment = ctx.heuristic == HEURISTIC_ASSIGNMENT;
+
+    MoveRecord rootMove = { -1, 0, 0, 0, 0 };
+    IDAFrame root = { startState, StateMetrics(), AssignmentMatrix(), MoveIterator(startState), rootMove,
+        startState.firstEmptyTube() };
+    root.metrics.compute(startState);
+    int threshold = root.metrics.heuristic(ctx.heuristic);
+    if (useAssignment) {
+        root.matrix.build(startState, root.metrics);
+        threshold = root.matrix.bound(root.metrics);
+    }
+
+    vector<MoveRecord> solution;
+    bool found = false;
+
+    // 每轮以 f = g + h 不超过 threshold 为界做深度优先搜索，下一轮的界取本轮被截断的最小 f
+    while (!found && !ctx.cancelled && threshold < INT_MAX) {
+        int nextThreshold = INT_MAX;
+        table.newIteration();
+        table.store(visitedKey(startState, ctx), 0);
+        path.clear();
+        path.push_back(root);
+        ctx.totalStatesExplored++;
+        if (root.metrics.isGoal(ctx.initialEmptyTubes)) {
+            found = true;
+            break;
+        }
+
+        while (!path.empty()) {
+            if (isCancelled(ctx)) {
+                ctx.cancelled = true;
+                break;
+            }
+            ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)path.size());
+
+            IDAFrame& top = path.back();
+            PourMove move;
+            if (!top.moves.next(move)) {
+                path.pop_back();
+                continue;
+            }
+            if (isPrunedMove(ctx, top.state, move, top.lastMove, top.firstEmpty)) continue;
+
+            int g = (int)path.size();
+            PackedState next = top.state;
+            next.applyPour(move.from, move.to, move.amount);
+            PackedState key = visitedKey(next, ctx);
+            if (table.seenWithin(key, g)) continue;
+            if (isDeadState(ctx, dead, key)) continue;
+
+            StateMetrics metrics = top.metrics;
+            metrics.apply(top.state, move.from, move.to, move.amount);
+            AssignmentMatrix matrix;
+            int h;
+            if (useAssignment) {
+                matrix = top.matrix;
+                matrix.applyPour(next, metrics, move.from, move.to);
+                h = matrix.bound(metrics);
+            }
+            else {
+                h = metrics.heuristic(ctx.heuristic);
+            }
+
+            if (g + h > threshold) {
+                nextThreshold = min(nextThreshold, g + h);
+                continue;
+            }
+
+            table.store(key, g);
+            ctx.totalStatesExplored++;
+            MoveRecord record = { 0, (uint8_t)move.from, (uint8_t)move.to, (uint8_t)move.amount, 0 };
+
+            if (metrics.isGoal(ctx.initialEmptyTubes)) {
+                for (size_t i = 1; i < path.size(); i++) {
+                    solution.push_back(path[i].lastMove);
+                }
+                solution.push_back(record);
+                found = true;
+                break;
+            }
+
+            if (provesDeadState(ctx, dead, next, key)) continue;
+
+            IDAFrame frame = { next, metrics, matrix, MoveIterator(next), record, next.firstEmptyTube() };
+            path.push_back(frame);
+            reportProgress(ctx, "IDA*", path.size());
+        }
+
+        threshold = nextThreshold;
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats = table.stats();
+    ctx.peakMemoryBytes = (long long)(table.memoryBytes() + dead.memoryBytes() + path.capacity() * sizeof(IDAFrame));
+    if (found) {
+        replayMoves(start, solution, ctx.solutionPath);
+    }
+    else if (!ctx.cancelled) {
+        // 没有任何分支被阈值截断，说明可达状态已全部展开
+        ctx.noSolutionReason = "无解：已搜索全部可达状态";
+    }
+    recordStats(ctx, "IDA*", found);
+    return found;
+}
+
+// ==================== ARA*（可随时中止的加权 A*） ====================
+// 先用较大的权重 w 快速得到一个解，之后逐轮降低 w，每轮得到不更长的解，直到 w = 1 时为最优解。
+// 各轮共用已生成的状态、g 值与搜索树：本轮已展开的状态若 g 再次变小，不重新进入开放表，
+// 而是记入 INCONS，下一轮开始时与开放表一起按新的 w 重新排序，因此前几轮的搜索结果得以复用。
+// 每轮结束时发布当前解，次优界取 min(w, 解长 / 开放表与 INCONS 中最小的 g + h)。
+
+// ARA* 生成过的一个状态
+struct ARAState {
+    PackedState state;
+    StateMetrics metrics;
+    int g;
+    int h;                      // 未加权的启发值，状态生成时计算一次
+    int node;                   // 当前最短已知路径在搜索树中的节点
+    unsigned closedIteration;   // 最近一次被展开的轮次，0 表示从未展开
+    bool inconsistent;          // 已记入 INCONS
+};
+
+// 开放表条目；g 与状态当前的 g 不同的条目已过期
+struct ARAEntry {
+    double f;       // g + w*h
+    int h;
+    int g;
+    int id;         // states 中的下标
+};
+
+struct ARACompare {
+    bool operator()(const ARAEntry& a, const ARAEntry& b) const {
+        if (a.f != b.f) return a.f > b.f;
+        return a.h > b.h;
+    }
+};
+
+bool ARAStar_Solve(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "ARA*", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    StateTable<int> ids(ctx.expectedStates);   // 去重键 -> states 下标
+    vector<ARAState> states;
+    vector<ARAEntry> open;                      // 按 ARACompare 组织的堆
+    vector<int> incons;
+    SearchTree tree;
+    ARACompare compare;
+    bool inserted;
+
+    ARAState root;
+    root.state = startState;
+    root.metrics.compute(startState);
+    root.g = 0;
+    root.h = rebuiltHeuristic(startState, root.metrics, ctx.heuristic);
+    root.node = tree.addRoot();
+    root.closedIteration = 0;
+    root.inconsistent = false;
+    states.push_back(root);
+    ids.insertOrFind(visitedKey(startState, ctx), 0, inserted);
+
+    double weight = max(1.0, ctx.anytimeWeight);
+    unsigned iteration = 1;
+    int bestCost = INT_MAX;
+    int bestNode = -1;
+    int publishedCost = INT_MAX;
+    double lowerBound = max(root.h, 1);     // 最优解长度的下界，随每轮结束时的界收紧
+    bool timedOut = false;
+
+    if (root.metrics.isGoal(ctx.initialEmptyTubes)) {
+        bestCost = 0;
+        bestNode = root.node;
+        lowerBound = 0;
+    }
+    else {
+        ARAEntry entry = { weight * root.h, root.h, 0, 0 };
+        open.push_back(entry);
+    }
+
+    while (true) {
+        // 按当前权重扩展，直到开放表中没有 f 小于当前解长的状态
+        while (!open.empty()) {
+            if (isCancelled(ctx)) {
+                ctx.cancelled = true;
+                break;
+            }
+            if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                    return (long long)(tree.bytesReserved() + ids.stats().memoryBytes + states.capacity() * sizeof(ARAState) +
+                        open.capacity() * sizeof(ARAEntry) + incons.capacity() * sizeof(int));
+                }, [&]() { ids.compact(); })) {
+                break;
+            }
+            if (ctx.timeLimitMs > 0 && (ctx.totalStatesExplored & 255) == 0 &&
+                duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count() >= ctx.timeLimitMs) {
+                timedOut = true;
+                break;
+            }
+
+            ARAEntry top = open.front();
+            if (top.g != states[top.id].g || states[top.id].closedIteration == iteration) {
+                pop_heap(open.begin(), open.end(), compare);
+                open.pop_back();
+                continue;
+            }
+            if (top.f >= bestCost) break;
+            pop_heap(open.begin(), open.end(), compare);
+            open.pop_back();
+
+            states[top.id].closedIteration = iteration;
+            ARAState current = states[top.id];  // states 随后可能扩容，取副本
+            ctx.totalStatesExplored++;
+
+            MoveRecord lastMove = tree[current.node];
+            int firstEmpty = current.state.firstEmptyTube();
+            MoveIterator moves(current.state);
+            PourMove move;
+            while (moves.next(move)) {
+                if (isPrunedMove(ctx, current.state, move, lastMove, firstEmpty)) continue;
+
+                int g = current.g + 1;
+                if (g >= bestCost) continue;    // 不可能改进当前解
+
+                PackedState next = current.state;
+                next.applyPour(move.from, move.to, move.amount);
+                int id = *ids.insertOrFind(visitedKey(next, ctx), (int)states.size(), inserted);
+                if (inserted) {
+                    ARAState child;
+                    child.metrics = current.metrics;
+                    child.metrics.apply(current.state, move.from, move.to, move.amount);
+                    child.h = rebuiltHeuristic(next, child.metrics, ctx.heuristic);
+                    child.closedIteration = 0;
+                    child.inconsistent = false;
+                    states.push_back(child);
+                }
+                else if (states[id].g <= g) {
+                    continue;
+                }
+
+                // 去重键相同的状态可能试管顺序不同，改为保存新路径实际到达的状态，使移动下标与搜索树一致
+                ARAState& child = states[id];
+                child.state = next;
+                child.metrics = current.metrics;
+                child.metrics.apply(current.state, move.from, move.to, move.amount);
+                child.g = g;
+                child.node = tree.addChild(current.node, move.from, move.to, move.amount);
+                if (child.metrics.isGoal(ctx.initialEmptyTubes)) {
+                    bestCost = g;
+                    bestNode = child.node;
+                    continue;
+                }
+
+                if (child.closedIteration == iteration) {
+                    if (!child.inconsistent) {
+                        child.inconsistent = true;
+                        incons.push_back(id);
+                    }
+                }
+                else {
+                    ARAEntry entry = { g + weight * child.h, child.h, g, id };
+                    open.push_back(entry);
+                    push_heap(open.begin(), open.end(), compare);
+                }
+            }
+
+            ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)(open.size() + incons.size()));
+            reportProgress(ctx, "ARA*", open.size() + incons.size());
+        }
+        if (ctx.cancelled || timedOut || stoppedByMemory(ctx) || bestNode < 0) break;
+
+        // 本轮结束：收紧最优解下界并发布当前解
+        int minCost = bestCost;
+        for (size_t i = 0; i < open.size(); i++) {
+            if (open[i].g == states[open[i].id].g) minCost = min(minCost, open[i].g + open[i].h);
+        }
+        for (size_t i = 0; i < incons.size(); i++) {
+            minCost = min(minCost, states[incons[i]].g + states[incons[i]].h);
+        }
+        double bound = minCost > 0 ? min(weight, (double)bestCost / minCost) : 1.0;
+        if (bound > 0) lowerBound = max(lowerBound, bestCost / bound);
+        ctx.suboptimalityBound = bound;
+        if (bestCost < publishedCost) {
+            publishedCost = bestCost;
+            replayMoves(start, tree.extractMoves(bestNode), ctx.solutionPath);
+            if (ctx.onSolution) ctx.onSolution(ctx.solutionPath, bound);
+        }
+        if (bound <= 1.0) break;
+
+        // 降低权重，INCONS 并回开放表，按新的 f 重新建堆
+        weight = max(1.0, weight - ctx.anytimeWeightStep);
+        iteration++;
+        vector<ARAEntry> rebuilt;
+        rebuilt.reserve(open.size() + incons.size());
+        for (size_t i = 0; i < open.size(); i++) {
+            const ARAState& s = states[open[i].id];
+            if (open[i].g != s.g) continue;
+            ARAEntry entry = { s.g + weight * s.h, s.h, s.g, open[i].id };
+            rebuilt.push_back(entry);
+        }
+        for (size_t i = 0; i < incons.size(); i++) {
+            ARAState& s = states[incons[i]];
+            s.inconsistent = false;
+            ARAEntry entry = { s.g + weight * s.h, s.h, s.g, incons[i] };
+            rebuilt.push_back(entry);
+        }
+        incons.clear();
+        open.swap(rebuilt);
+        make_heap(open.begin(), open.end(), compare);
+    }
+
+    // 中途停止时，最后一轮找到的更短解按已知下界估计次优界
+    if (bestNode >= 0 && bestCost < publishedCost) {
+        replayMoves(start, tree.extractMoves(bestNode), ctx.solutionPath);
+        ctx.suboptimalityBound = lowerBound > 0 ? max(1.0, bestCost / lowerBound) : 1.0;
+        if (ctx.onSolution) ctx.onSolution(ctx.solutionPath, ctx.suboptimalityBound);
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    ctx.tableStats = ids.stats();
+    ctx.peakMemoryBytes = (long long)(tree.bytesReserved() + ctx.tableStats.memoryBytes +
+        states.capacity() * sizeof(ARAState) + open.capacity() * sizeof(ARAEntry) + incons.capacity() * sizeof(int));
+    bool found = bestNode >= 0;
+    if (!found && timedOut) {
+        ctx.noSolutionReason = "超时：未找到解";
+    }
+    else if (!found && !ctx.cancelled && !stoppedByMemory(ctx)) {
+        ctx.noSolutionReason = "无解：已搜索全部可达状态";
+    }
+    recordStats(ctx, "ARA*", found);
+    return found;
+}
+
+// ==================== 束搜索 ====================
+// 每层只保留启发值最小的 beamWidth 个状态：内存与每层耗时都有上界，但不保证找到解，也不保证最短。
+// 在 PackedState 范围内的关卡用 PackedState 与 StateTable；更大的关卡（20~40 个试管）用不受16个试管限制的 WideState，
+// 状态与去重键都存成连续的定长记录。两种状态共用同一份搜索过程与剪枝规则。
+// 层内按去重键去重，并跳过之前各层保留过的状态（已见集合不超过 宽度 × 深度）。
+// 某层没有新状态或达到深度上限即本轮失败；beamRestarts 大于0时宽度翻倍后重新搜索。
+
+// 本层生成的候选：index 为候选在状态存储中的下标
+struct BeamCandidate {
+    uint32_t index;
+    int h;
+    MoveRecord move;        // 到达该状态的移动，parent 为上一层中的下标
+};
+
+// 按 GameState 构造宽状态，超出编码范围时返回 false
+static bool wideState(const GameState& state, WideState& wide) {
+    int n = (int)state.tubes.size();
+    if (n == 0 || n > WIDE_MAX_TUBES) return false;
+    int capacity = state.tubes[0].capacity;
+    if (capacity <= 0 || capacity > WIDE_MAX_CAPACITY) return false;
+
+    wide.reset(n, capacity);
+    for (int i = 0; i < n; i++) {
+        const Tube& tube = state.tubes[i];
+        if (tube.capacity != capacity || tube.isOverCapacity()) return false;
+        for (int color : tube.colors) {
+            if (color <= 0 || color > WIDE_MAX_COLOR) return false;
+            wide.push(i, color);
+        }
+    }
+    return true;
+}
+
+// 束搜索的状态存储：当前层、本层候选，以及已见集合与本层去重集合。
+// 候选按生成顺序编号，advance 把选中的候选依次作为下一层并记入已见集合
+class PackedBeamStore {
+public:
+    typedef PackedState State;
+
+    explicit PackedBeamStore(const SolverContext& context) : ctx(context) {}
+
+    void begin(const PackedState& start) {
+        layer.reset(start.numTubes, start.capacity);
+        candidates.reset(start.numTubes, start.capacity);
+        layer.push(start);
+        bool inserted;
+        seen.insertOrFind(visitedKey(start, ctx), 0, inserted);
+    }
+
+    size_t layerSize() const { return layer.size(); }
+    void load(size_t i, PackedState& out) const { out = layer[i]; }
+    size_t candidateCount() const { return candidates.size(); }
+
+    // 之前各层保留过或本层已生成过时返回 false
+    bool addCandidate(const PackedState& state) {
+        PackedState key = visitedKey(state, ctx);
+        if (seen.find(key) != NULL) return false;
+        bool inserted;
+        layerKeys.insertOrFind(key, 0, inserted);
+        if (!inserted) return false;
+        candidates.push(state);
+        return true;
+    }
+
+    void advance(const vector<BeamCandidate>& kept) {
+        layer.clear();
+        for (size_t i = 0; i < kept.size(); i++) {
+            layer.pushRecord(candidates.record(kept[i].index));
+            bool inserted;
+            seen.insertOrFind(visitedKey(candidates[kept[i].index], ctx), 0, inserted);
+        }
+        candidates.clear();
+        layerKeys = StateTable<uint8_t>();
+    }
+
+    size_t memoryBytes() const {
+        return layer.memoryBytes() + candidates.memoryBytes() +
+            seen.stats().memoryBytes + layerKeys.stats().memoryBytes;
+    }
+
+private:
+    const SolverContext& ctx;
+    PackedStateArray layer;
+    PackedStateArray candidates;
+    StateTable<uint8_t> seen;           // 之前各层保留过的状态
+    StateTable<uint8_t> layerKeys;      // 本层已生成的状态
+};
+
+class WideBeamStore {
+public:
+    typedef WideState State;
+
+    explicit WideBeamStore(const SolverContext& ctx) : encoder(ctx.canonicalizeTubes, ctx.canonicalizeColors) {}
+
+    void begin(const WideState& start) {
+        layer.reset(start.numTubes, start.capacity);
+        candidates.reset(start.numTubes, start.capacity);
+        key.resize(start.cells.size());
+        seen.reset(key.size());
+        layerKeys.reset(key.size());
+        layer.push(start);
+        encoder.encode(start, &key[0]);
+        seen.insert(&key[0]);
+    }
+
+    size_t layerSize() const { return layer.size(); }
+    void load(size_t i, WideState& out) const { layer.load(i, out); }
+    size_t candidateCount() const { return candidates.size(); }
+
+    // 本层去重集合与候选一一对应：第 i 个候选的键即 layerKeys 中第 i 个键
+    bool addCandidate(const WideState& state) {
+        encoder.encode(state, &key[0]);
+        if (seen.contains(&key[0]) || !layerKeys.insert(&key[0])) return false;
+        candidates.push(state);
+        return true;
+    }
+
+    void advance(const vector<BeamCandidate>& kept) {
+        layer.clear();
+        for (size_t i = 0; i < kept.size(); i++) {
+            layer.pushFrom(candidates, kept[i].index);
+            seen.insert(layerKeys.keyAt(kept[i].index));
+        }
+        candidates.clear();
+        layerKeys.clear();
+    }
+
+    size_t memoryBytes() const {
+        return layer.memoryBytes() + candidates.memoryBytes() + seen.memoryBytes() + layerKeys.memoryBytes();
+    }
+
+private:
+    WideKeyEncoder encoder;
+    vector<uint8_t> key;
+    WideStateArray layer;
+    WideStateArray candidates;
+    WideKeySet seen;
+    WideKeySet layerKeys;
+};
+
+static int beamHeuristic(const PackedState& state) {
+    StateMetrics metrics;
+    metrics.compute(state);
+    return metrics.heuristic(HEURISTIC_BLOCKS);
+}
+
+static int beamHeuristic(const WideState& state) {
+    return state.blockHeuristic();
+}
+
+// 以固定宽度搜索一轮；找到目标时写出移动序列
+template <typename Store>
+static bool beamPass(const typename Store::State& start, SolverContext& ctx, int width, int maxDepth,
+    vector<MoveRecord>& solution) {
+    typedef typename Store::State State;
+    Store store(ctx);
+    store.begin(start);
+    vector<vector<MoveRecord> > history;    // history[d][i]：第 d+1 层第 i 个状态的来历
+    vector<BeamCandidate> candidates;
+    MoveRecord noMove = { -1, 0, 0, 0, 0 };
+    State state;
+    State child;
+
+    for (int depth = 0; depth < maxDepth; depth++) {
+        candidates.clear();
+        for (size_t i = 0; i < store.layerSize(); i++) {
+            if (isCancelled(ctx)) {
+                ctx.cancelled = true;
+                return false;
+            }
+            if (memoryCheckDue(ctx) && overMemoryBudget(ctx, [&]() {
+                    return (long long)(store.memoryBytes() + candidates.capacity() * sizeof(BeamCandidate) +
+                        history.size() * width * sizeof(MoveRecord));
+                })) {
+                return false;
+            }
+            store.load(i, state);
+            ctx.totalStatesExplored++;
+            const MoveRecord& lastMove = depth == 0 ? noMove : history.back()[i];
+            int firstEmpty = state.firstEmptyTube();
+
+            for (int from = 0; from < state.numTubes; from++) {
+                if (state.isEmpty(from)) continue;
+                for (int to = 0; to < state.numTubes; to++) {
+                    int amount = state.pourAmount(from, to);
+                    if (amount == 0) continue;
+                    PourMove move = { from, to, amount, state.topColor(from) };
+                    if (isPrunedMove(ctx, state, move, lastMove, firstEmpty)) continue;
+
+                    child = state;
+                    child.applyPour(from, to, amount);
+                    BeamCandidate candidate;
+                    candidate.move.parent = (int)i;
+                    candidate.move.from = (uint8_t)from;
+                    candidate.move.to = (uint8_t)to;
+                    candidate.move.amount = (uint8_t)amount;
+                    candidate.move.reserved = 0;
+
+                    if (child.isGoal(ctx.initialEmptyTubes)) {
+                        // 沿各层来历回溯出移动序列
+                        solution.clear();
+                        solution.push_back(candidate.move);
+                        int index = (int)i;
+                        for (int d = depth - 1; d >= 0; d--) {
+                            solution.push_back(history[d][index]);
+                            index = history[d][index].parent;
+                        }
+                        reverse(solution.begin(), solution.end());
+                        return true;
+                    }
+
+                    if (!store.addCandidate(child)) continue;
+                    candidate.index = (uint32_t)(store.candidateCount() - 1);
+                    candidate.h = beamHeuristic(child);
+                    candidates.push_back(candidate);
+                }
+            }
+        }
+
+        ctx.maxStatesInMemory = max(ctx.maxStatesInMemory, (int)candidates.size());
+        ctx.peakMemoryBytes = max(ctx.peakMemoryBytes, (long long)(store.memoryBytes() +
+            candidates.capacity() * sizeof(BeamCandidate) + history.size() * width * sizeof(MoveRecord)));
+        if (candidates.empty()) return false;
+
+        // 只保留启发值最小的 width 个；启发值相同时保持生成顺序，结果可复现
+        if ((int)candidates.size() > width) {
+            stable_sort(candidates.begin(), candidates.end(), [](const BeamCandidate& a, const BeamCandidate& b) {
+                return a.h < b.h;
+            });
+            candidates.resize(width);
+        }
+
+        vector<MoveRecord> moves(candidates.size());
+        for (size_t i = 0; i < candidates.size(); i++) moves[i] = candidates[i].move;
+        history.push_back(moves);
+        store.advance(candidates);
+        reportProgress(ctx, "Beam", store.layerSize());
+    }
+    return false;
+}
+
+// 按编码选择状态表示，宽度逐轮翻倍重试
+template <typename Store>
+static bool beamSearch(const typename Store::State& start, SolverContext& ctx, int totalUnits, vector<MoveRecord>& moves) {
+    // 深度上限：默认为总水量的两倍，每步至少移动一格
+    int maxDepth = ctx.beamMaxDepth > 0 ? ctx.beamMaxDepth : max(1, 2 * totalUnits);
+    bool found = false;
+    int width = max(1, ctx.beamWidth);
+    for (int attempt = 0; !found && attempt <= ctx.beamRestarts; attempt++) {
+        ctx.beamWidthUsed = width;
+        found = beamPass<Store>(start, ctx, width, maxDepth, moves);
+        if (ctx.cancelled || stoppedByMemory(ctx)) break;
+        if (width > INT_MAX / 2) break;
+        width *= 2;
+    }
+    return found;
+}
+
+bool Beam_Solve(const GameState& start, SolverContext& ctx) {
+    resetOutputs(ctx);
+    WideState wide;
+    if (start.isInvalid) {
+        ctx.noSolutionReason = "无解：初始状态无效";
+        recordStats(ctx, "Beam", false);
+        return false;
+    }
+    if (!wideState(start, wide)) {
+        ctx.noSolutionReason = "无法求解：超出编码范围（最多255个试管、容量255、颜色255）";
+        recordStats(ctx, "Beam", false);
+        return false;
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    int totalUnits = 0;
+    for (int i = 0; i < wide.numTubes; i++) totalUnits += wide.tubeSize(i);
+
+    vector<MoveRecord> moves;
+    bool found = wide.isGoal(ctx.initialEmptyTubes);
+    PackedState packed;
+    if (!found && packState(start, packed)) {
+        found = beamSearch<PackedBeamStore>(packed, ctx, totalUnits, moves);
+    }
+    else if (!found) {
+        found = beamSearch<WideBeamStore>(wide, ctx, totalUnits, moves);
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    if (found) {
+        replayMoves(start, moves, ctx.solutionPath);
+    }
+    else if (!ctx.cancelled) {
+        ctx.noSolutionReason = "束搜索未找到解（搜索不完备，不能据此判定无解）";
+    }
+    recordStats(ctx, "Beam", found);
+    return found;
+}
+
+// ==================== 组合求解 ====================
+// 每个成员在自己的线程中用一份独立的 SolverContext 求解，共用一个取消标志。
+// 第一个满足质量要求的解胜出，随后置位取消标志，其余成员在下一次检查时返回。
+// 各成员的搜索都是完备的：任一成员未被取消而搜索完毕仍无解，说明无解，同样结束比赛。
+
+vector<PortfolioMember> DefaultPortfolio() {
+    PortfolioMember members[] = {
+        { "BFS", HEURISTIC_BLOCKS, 1.0 },
+        { "DFS", HEURISTIC_BLOCKS, 1.0 },
+        { "A*", HEURISTIC_BLOCKS, 1.0 },
+        { "A*", HEURISTIC_ASSIGNMENT, 1.0 },
+        { "A*", HEURISTIC_BLOCKS, 3.0 },
+    };
+    return vector<PortfolioMember>(members, members + sizeof(members) / sizeof(members[0]));
+}
+
+string GetPortfolioMemberName(const PortfolioMember& member) {
+    if (member.algorithm != "A*" && member.algorithm != "IDA*") return member.algorithm;
+    char name[64];
+    if (member.algorithm == "A*" && member.weight > 1.0) {
+        sprintf(name, "加权A*(%s w=%.1f)", GetHeuristicName(member.heuristic), member.weight);
+    }
+    else {
+        sprintf(name, "%s(%s)", member.algorithm.c_str(), GetHeuristicName(member.heuristic));
+    }
+    return name;
+}
+
+bool IsOptimalMember(const PortfolioMember& member) {
+    if (member.algorithm == "BFS" || member.algorithm == "IDA*") return true;
+    return member.algorithm == "A*" && member.weight <= 1.0;
+}
+
+bool Portfolio_Solve(const GameState& start, SolverContext& ctx) {
+    PackedState startState;
+    if (!prepareStart(start, ctx, startState)) {
+        recordStats(ctx, "组合", false);
+        return false;
+    }
+    if (ctx.portfolio.empty()) ctx.portfolio = DefaultPortfolio();
+    const vector<PortfolioMember>& members = ctx.portfolio;
+    for (size_t i = 0; i < members.size(); i++) {
+        const string& algorithm = members[i].algorithm;
+        if (algorithm != "BFS" && algorithm != "DFS" && algorithm != "A*" && algorithm != "IDA*") {
+            ctx.noSolutionReason = "组合求解不支持的成员: " + algorithm;
+            recordStats(ctx, "组合", false);
+            return false;
+        }
+    }
+
+    auto startTime = high_resolution_clock::now();
+
+    size_t count = members.size();
+    atomic<bool> cancel(false);
+    vector<SolverContext> contexts(count);
+    for (size_t i = 0; i < count; i++) {
+        SolverContext& member = contexts[i];
+        member = ctx;
+        member.portfolio.clear();
+        member.onProgress = nullptr;    // 进度回调不一定线程安全；进度通道线程安全，各成员照常发布
+        member.searchThreads = 1;       // 成员之间已经并行
+        member.presolveStates = 0;      // 无解判定由外层 SolveWithAlgorithm 做一次即可
+        member.cancelFlag = &cancel;
+        member.heuristic = members[i].heuristic;
+        member.heuristicWeight = members[i].weight;
+        // 成员同时运行，各分得预算的一份；超出份额的成员直接退出，由其余成员继续
+        member.memoryBudgetBytes = ctx.memoryBudgetBytes / (long long)count;
+        member.memoryAction = member.memoryAction == MEMORY_COMPACT ? MEMORY_COMPACT : MEMORY_ABORT;
+    }
+
+    mutex lock;
+    condition_variable finished;
+    size_t finishedCount = 0;
+    int winner = -1;
+
+    auto run = [&](size_t i) {
+        SolverContext& member = contexts[i];
+        bool found = SolveWithAlgorithm(members[i].algorithm, start, member);
+
+        lock_guard<mutex> guard(lock);
+        finishedCount++;
+        bool accepted = found && (ctx.portfolioQuality == QUALITY_ANY || IsOptimalMember(members[i]));
+        bool provedUnsolvable = !found && !member.cancelled && !stoppedByMemory(member);
+        if (winner < 0 && (accepted || provedUnsolvable)) {
+            winner = (int)i;
+            cancel.store(true);
+        }
+        finished.notify_all();
+    };
+
+    vector<thread> threads;
+    for (size_t i = 0; i < count; i++) {
+        threads.push_back(thread(run, i));
+    }
+    {
+        // 等待全部成员返回；外部取消时转告各成员
+        unique_lock<mutex> guard(lock);
+        while (finishedCount < count) {
+            finished.wait_for(guard, milliseconds(50));
+            if (isCancelled(ctx)) cancel.store(true);
+        }
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    auto endTime = high_resolution_clock::now();
+    ctx.solvingTime = duration_cast<milliseconds>(endTime - startTime).count();
+
+    // 资源统计为全部成员之和（它们同时运行），表统计取胜出者
+    long long busyMillis = 0;
+    ctx.portfolioStats.clear();
+    for (size_t i = 0; i < count; i++) {
+        const SolverContext& member = contexts[i];
+        AlgorithmStats stats = member.stats;
+        stats.algorithmName = GetPortfolioMemberName(members[i]);
+        ctx.portfolioStats.push_back(stats);
+        ctx.totalStatesExplored += member.totalStatesExplored;
+        ctx.maxStatesInMemory += member.maxStatesInMemory;
+        ctx.peakMemoryBytes += member.peakMemoryBytes;
+        busyMillis += member.solvingTime;
+        for (int r = 0; r < PRUNE_RULE_COUNT; r++) ctx.prunedByRule[r] += member.prunedByRule[r];
+        if (member.memoryActionTaken != MEMORY_NONE && ctx.memoryActionTaken != MEMORY_ABORT) {
+            ctx.memoryActionTaken = member.memoryActionTaken;
+        }
+    }
+    ctx.threadsUsed = (int)count;
+    ctx.parallelSpeedup = ctx.solvingTime > 0 ? (double)busyMillis / ctx.solvingTime : 1.0;
+    ctx.portfolioWinner = winner;
+
+    bool found = false;
+    if (winner >= 0) {
+        const SolverContext& best = contexts[winner];
+        found = !best.solutionPath.empty();
+        ctx.solutionPath = best.solutionPath;
+        ctx.noSolutionReason = best.noSolutionReason;
+        ctx.tableStats = best.tableStats;
+    }
+    else if (isCancelled(ctx)) {
+        ctx.cancelled = true;
+    }
+    else if (!stoppedByMemory(ctx)) {
+        ctx.noSolutionReason = "组合求解：没有成员给出满足质量要求的解";
+    }
+    if (found && ctx.memoryActionTaken == MEMORY_ABORT) ctx.memoryActionTaken = MEMORY_NONE;  // 其他成员已给出解
+    recordStats(ctx, "组合", found);
+    return found;
+}
+
+// ==================== 求解前的无解判定 ====================
+// 目标要求每个非空试管单色、每种颜色只在一个试管中、空瓶数等于 initialEmptyTubes，
+// 由此得到几条只需计数的必要条件；紧约束关卡常见的死局（没有合法移动、几个试管之间来回倒却始终解不开）
+// 可达状态很少，穷举至多 probeStates 个状态即可证明。都不成立时返回 false，交给完整搜索。
+bool ProveUnsolvable(const GameState& start, int initialEmptyTubes, size_t probeStates, string& reason,
+    int* statesExamined) {
+    char buf[160];
+    if (statesExamined != NULL) *statesExamined = 0;
+
+    map<int, int> amounts;      // 颜色 -> 总格数
+    int capacity = 0;
+    for (size_t i = 0; i < start.tubes.size(); i++) {
+        capacity = max(capacity, start.tubes[i].capacity);
+        for (size_t j = 0; j < start.tubes[i].colors.size(); j++) {
+            amounts[start.tubes[i].colors[j]]++;
+        }
+    }
+    for (map<int, int>::const_iterator it = amounts.begin(); it != amounts.end(); ++it) {
+        if (it->second > capacity) {
+            sprintf(buf, "无解：%s共 %d 格，一个试管装不下（容量 %d）", GetColorName(it->first), it->second, capacity);
+            reason = buf;
+            return true;
+        }
+    }
+    int targetTubes = (int)start.tubes.size() - initialEmptyTubes;
+    if ((int)amounts.size() != targetTubes) {
+        sprintf(buf, "无解：颜色数 (%d) 与目标状态的非空试管数 (%d) 不符", (int)amounts.size(), targetTubes);
+        reason = buf;
+        return true;
+    }
+
+    PackedState packed;
+    if (!packState(start, packed) || packed.isGoal(initialEmptyTubes)) return false;
+    PourMove move;
+    if (!MoveIterator(packed).next(move)) {
+        reason = "无解：初始状态没有合法移动（各试管顶部互相阻塞）";
+        if (statesExamined != NULL) *statesExamined = 1;
+        return true;
+    }
+    if (probeStates == 0) return false;
+
+    vector<PackedState> region;
+    bool exhausted = DeadStateCache::ExhaustRegion(packed.canonical(), initialEmptyTubes, true, false, probeStates, region);
+    if (statesExamined != NULL) *statesExamined = (int)region.size();
+    if (!exhausted) return false;
+    sprintf(buf, "无解：可达状态只有 %d 个，都不是目标（试管之间循环阻塞）", (int)region.size());
+    reason = buf;
+    return true;
+}
+
+static bool solveByName(const string& algorithm, const GameState& start, SolverContext& ctx) {
+    if (algorithm == "BFS") return BFS_Solve(start, ctx);
+    if (algorithm == "DFS") return DFS_Solve(start, ctx);
+    if (algorithm == "A*") return AStar_Solve(start, ctx);
+    if (algorithm == "IDA*") return IDAStar_Solve(start, ctx);
+    if (algorithm == "ARA*") return ARAStar_Solve(start, ctx);
+    if (algorithm == "Beam") return Beam_Solve(start, ctx);
+    if (algorithm == "Portfolio") return Portfolio_Solve(start, ctx);
+    ctx.noSolutionReason = "未知算法: " + algorithm;
+    return false;
+}
+
+bool SolveWithAlgorithm(const string& algorithm, const GameState& start, SolverContext& ctx) {
+    if (!start.isInvalid && ctx.presolveStates > 0) {
+        auto startTime = high_resolution_clock::now();
+        string reason;
+        int examined = 0;
+        if (ProveUnsolvable(start, ctx.initialEmptyTubes, ctx.presolveStates, reason, &examined)) {
+            resetOutputs(ctx);
+            ctx.noSolutionReason = reason;
+            ctx.totalStatesExplored = examined;
+            ctx.solvingTime = duration_cast<milliseconds>(high_resolution_clock::now() - startTime).count();
+            recordStats(ctx, algorithm == "Portfolio" ? "组合" : algorithm.c_str(), false);
+            return false;
+        }
+    }
+
+    bool found = solveByName(algorithm, start, ctx);
+
+    // 超出内存预算且选择改用 IDA*：从头求解，置换表按预算收缩。
+    // IDA* 本身已是内存有界的算法；束搜索面向超出位编码的大关卡，无法改用 IDA*
+    if (found || !stoppedByMemory(ctx) || ctx.memoryAction != MEMORY_FALLBACK ||
+        algorithm == "IDA*" || algorithm == "Beam" || algorithm == "Portfolio") {
+        return found;
+    }
+
+    long long spentTime = ctx.solvingTime;
+    int spentStates = ctx.totalStatesExplored;
+    long long spentPeak = ctx.peakMemoryBytes;
+    found = IDAStar_Solve(start, ctx);
+
+    // 统计累计两次搜索，原因与状态沿用 IDA* 的结果
+    ctx.solvingTime += spentTime;
+    ctx.totalStatesExplored += spentStates;
+    ctx.peakMemoryBytes = max(ctx.peakMemoryBytes, spentPeak);
+    ctx.memoryActionTaken = MEMORY_FALLBACK;
+    ctx.stats.algorithmName = algorithm + "→IDA*";
+    ctx.stats.solvingTime = ctx.solvingTime;
+    ctx.stats.statesExplored = ctx.totalStatesExplored;
+    ctx.stats.peakMemoryBytes = ctx.peakMemoryBytes;
+    ctx.stats.memoryAction = MEMORY_FALLBACK;
+    return found;
+}
@@ -0,0 +1,371 @@
+﻿#pragma once
+// ==================== 求解器核心（无界面依赖） ====================
+// 本文件只依赖标准库，可在 Linux 批处理节点上编译；
+// 图形界面 (ConsoleApplication1.cpp) 与命令行批处理程序 (BatchSolver.cpp) 共用。
+#include <stdio.h>
+#include <vector>
+#include <string>
+#include <functional>
+#include <atomic>
+#include "PackedState.h"
+#include "StateTable.h"
+#include "SearchTree.h"
+#include "MoveIterator.h"
+#include "AssignmentHeuristic.h"
+#include "TranspositionTable.h"
+#include "ProgressChannel.h"
+
+using namespace std;
+
+const char* GetColorName(int index);
+
+// ==================== 数据结构定义 ====================
+struct Tube {
+    vector<int> colors;  // 从底部到顶部的水颜色 (0=空)
+    int capacity;        // 试管容量
+
+    Tube(int cap = 4) : capacity(cap) {}
+
+    bool isEmpty() const { return colors.empty(); }
+    bool isFull() const { return (int)colors.size() >= capacity; }
+    int size() const { return (int)colors.size(); }
+    int freeSpace() const { return capacity - (int)colors.size(); }
+
+    // 获取顶部颜色，空试管返回-1
+    int topColor() const {
+        if (colors.empty()) return -1;
+        return colors.back();
+    }
+
+    // 获取顶部连续同色水的数量
+    int topSegmentSize() const {
+        if (colors.empty()) return 0;
+        int topColor = colors.back();
+        int count = 0;
+        for (auto it = colors.rbegin(); it != colors.rend(); ++it) {
+            if (*it == topColor) count++;
+            else break;
+        }
+        return count;
+    }
+
+    // 是否可以倒入颜色为color的水
+    bool canPourInto(int color) const {
+        if (isFull()) return false;
+        return isEmpty() || topColor() == color;
+    }
+
+    // 倒入指定颜色的水
+    void pourIn(int color, int amount) {
+        for (int i = 0; i < amount && !isFull(); i++) {
+            colors.push_back(color);
+        }
+    }
+
+    // 倒出指定数量的水
+    void pourOut(int amount) {
+        if (amount >= (int)colors.size()) {
+            colors.clear();
+        }
+        else {
+            colors.resize(colors.size() - amount);
+        }
+    }
+
+    // 检查试管是否已完成（只有一种颜色或为空）
+    bool isComplete() const {
+        if (colors.empty()) return true;
+        int firstColor = colors[0];
+        for (int color : colors) {
+            if (color != firstColor) return false;
+        }
+        return true;
+    }
+
+    // 检查是否超容（用于可视化）
+    bool isOverCapacity() const {
+        return (int)colors.size() > capacity;
+    }
+};
+
+// 游戏状态
+struct GameState {
+    vector<Tube> tubes;
+    string operation;
+    GameState* parent;
+    int gCost;  // 从起始状态到当前状态的代价
+    int hCost;  // 启发式代价估计
+    int moveFrom;  // 从哪个试管移动
+    int moveTo;    // 移动到哪个试管
+    int moveAmount; // 移动数量
+    bool isInvalid; // 是否为无效状态（用于可视化）
+
+    GameState() : parent(NULL), gCost(0), hCost(0), moveFrom(-1), moveTo(-1), moveAmount(0), isInvalid(false) {}
+
+    GameState(const GameState& other) {
+        tubes = other.tubes;
+        operation = other.operation;
+        parent = other.parent;
+        gCost = other.gCost;
+        hCost = other.hCost;
+        moveFrom = other.moveFrom;
+        moveTo = other.moveTo;
+        moveAmount = other.moveAmount;
+        isInvalid = other.isInvalid;
+    }
+
+    GameState& operator=(const GameState& other) {
+        tubes = other.tubes;
+        operation = other.operation;
+        parent = other.parent;
+        gCost = other.gCost;
+        hCost = other.hCost;
+        moveFrom = other.moveFrom;
+        moveTo = other.moveTo;
+        moveAmount = other.moveAmount;
+        isInvalid = other.isInvalid;
+        return *this;
+    }
+
+    // 生成状态唯一键
+    string getKey() const {
+        string key;
+        for (const auto& tube : tubes) {
+            key += "[";
+            for (int color : tube.colors) {
+                key += to_string(color) + ",";
+            }
+            key += "];";
+        }
+        return key;
+    }
+
+    // 计算启发式代价 - 改进为可采纳启发函数
+    int calculateHeuristic() const {
+        int cost = 0;
+
+        // 计算每个试管中颜色变化的次数
+        for (const auto& tube : tubes) {
+            if (tube.isEmpty()) continue;
+
+            // 统计颜色变化的次数
+            int colorChanges = 0;
+            for (size_t i = 1; i < tube.colors.size(); i++) {
+                if (tube.colors[i] != tube.colors[i - 1]) {
+                    colorChanges++;
+                }
+            }
+
+            // 每个颜色变化至少需要一次移动来修正
+            cost += colorChanges;
+        }
+
+        // 保守估计，确保不会高估实际代价
+        return cost / 2;
+    }
+
+    // 深度复制
+    GameState deepCopy() const {
+        GameState newState;
+        newState.tubes = this->tubes;
+        newState.operation = this->operation;
+        newState.parent = this->parent;
+        newState.gCost = this->gCost;
+        newState.hCost = this->hCost;
+        newState.moveFrom = this->moveFrom;
+        newState.moveTo = this->moveTo;
+        newState.moveAmount = this->moveAmount;
+        newState.isInvalid = this->isInvalid;
+        return newState;
+    }
+
+    // 获取移动描述
+    string getMoveDescription() const {
+        if (moveFrom == -1 || moveTo == -1) return "初始状态";
+
+        char buffer[100];
+        int fromTube = moveFrom + 1;
+        int toTube = moveTo + 1;
+        int color = tubes[moveFrom].topColor();
+        sprintf(buffer, "从试管%d倒入试管%d (颜色: %s, 数量: %d)",
+            fromTube, toTube, GetColorName(color), moveAmount);
+        return string(buffer);
+    }
+
+    // 检查是否为无效状态（超容）
+    bool hasOverCapacityTube() const {
+        for (const auto& tube : tubes) {
+            if (tube.isOverCapacity()) return true;
+        }
+        return false;
+    }
+};
+
+// 后继剪枝规则：每条规则可单独开关，且都不会改变 BFS/A* 的最优解长度
+enum PruneRule {
+    PRUNE_UNIFORM_TO_EMPTY = 0,     // 单色试管整体倒入空试管：结果只是试管换位
+    PRUNE_EXTRA_EMPTY,              // 有多个空试管时只倒入第一个，其余结果互为换位
+    PRUNE_UNDO,                     // 原量倒回上一步的源试管：结果等于祖父状态
+    PRUNE_COMPLETED,                // 从已装满的单色试管倒出：可解关卡中只能倒入空试管
+    PRUNE_DEAD_STATE,               // 已证明到不了目标的状态（见 DeadStateCache）
+    PRUNE_RULE_COUNT
+};
+const unsigned PRUNE_NONE = 0;
+const unsigned PRUNE_ALL = (1u << PRUNE_RULE_COUNT) - 1;
+
+const char* GetPruneRuleName(int rule);
+const char* GetHeuristicName(int heuristic);
+
+// 内存预算用尽时的处理方式；作为结果时 MEMORY_NONE 表示未触发预算
+enum MemoryBudgetAction {
+    MEMORY_NONE = 0,
+    MEMORY_ABORT,           // 放弃搜索
+    MEMORY_FALLBACK,        // 放弃当前算法，改用内存有界的 IDA* 重新求解
+    MEMORY_COMPACT,         // 压缩各表（提高负载因子上限并收缩）后继续，仍超出时放弃
+    MEMORY_ACTION_COUNT
+};
+const char* GetMemoryActionName(int action);
+
+// 组合求解（Portfolio_Solve）的一个成员：算法名、启发函数与启发权重
+struct PortfolioMember {
+    string algorithm;   // "BFS" / "DFS" / "A*" / "IDA*"
+    int heuristic;      // A* / IDA* 使用的启发函数
+    double weight;      // A* 的启发权重，大于1时为加权 A*
+};
+
+// 组合求解接受的解的质量
+enum PortfolioQuality {
+    QUALITY_ANY = 0,        // 任一成员找到的解
+    QUALITY_OPTIMAL,        // 只接受保证最优的成员（BFS、未加权的 A*、IDA*）找到的解
+    QUALITY_COUNT
+};
+
+// 默认成员：BFS、DFS、两种启发函数的 A*、加权 A*
+vector<PortfolioMember> DefaultPortfolio();
+string GetPortfolioMemberName(const PortfolioMember& member);
+bool IsOptimalMember(const PortfolioMember& member);
+
+// 算法性能统计
+struct AlgorithmStats {
+    int statesExplored;
+    int maxMemory;
+    long long solvingTime;
+    int solutionLength;
+    string algorithmName;
+    bool hasSolution;
+    string solutionStatus;
+    long long peakMemoryBytes;  // 峰值内存（节点池 + 已访问表 + 待扩展队列）
+    long long prunedByRule[PRUNE_RULE_COUNT];  // 各剪枝规则去掉的后继数
+    long long memoryBudgetBytes;    // 求解时的内存预算，0 表示不限
+    int memoryAction;               // 触发预算后实际采取的处理（MemoryBudgetAction）
+
+    explicit AlgorithmStats(const string& name = "") : statesExplored(0), maxMemory(0), solvingTime(0), solutionLength(0),
+        algorithmName(name), hasSolution(false), solutionStatus("未运行"), peakMemoryBytes(0),
+        memoryBudgetBytes(0), memoryAction(MEMORY_NONE) {
+        for (int i = 0; i < PRUNE_RULE_COUNT; i++) prunedByRule[i] = 0;
+    }
+};
+
+// ==================== 求解上下文 ====================
+// 原先由 GUI 全局变量承载的输入/输出，现集中在此，便于多线程批量求解时每个任务各持一份
+struct SolverContext {
+    // 输入
+    int initialEmptyTubes;          // 初始空瓶数（目标判定用）
+    int progressInterval;           // 每探索多少状态回调一次进度
+    size_t expectedStates;          // 预计状态数，用于预分配已访问表（0 表示按需增长）
+    bool canonicalizeTubes;         // 去重时忽略试管排列顺序（见 PackedState::canonical）
+    bool canonicalizeColors;        // 去重时忽略颜色编号（见 PackedState::colorNormalized）
+    unsigned pruneRules;            // 启用的剪枝规则位掩码（1 << PruneRule）
+    int heuristic;                  // A* / IDA* 使用的启发函数（HeuristicType）
+    size_t transpositionBytes;      // IDA* 置换表的内存预算（字节），表大小固定不扩容
+    int transpositionPolicy;        // IDA* 置换表满时的替换策略（TableReplacePolicy）
+    bool layeredBFS;                // BFS 按层同步：每层为排序去重的数组，批量去重，见 BFS_Solve
+    bool externalBFS;               // BFS 按层同步且各层存于磁盘，用于内存放不下的穷举（优先于 layeredBFS）
+    string scratchDirectory;        // 外存 BFS 的临时文件目录，为空表示当前目录
+    size_t externalMemoryBytes;     // 外存 BFS 的内存预算（字节），决定生成缓冲区与读写缓冲区大小
+    int searchThreads;              // 单个关卡内部的搜索线程数（大于1时 BFS 按层并行、A* 改用 HDA*），0 表示全部核心
+    double heuristicWeight;         // A* 的启发权重 w，按 f = g + w*h 排序；大于1时为加权 A*，解不保证最优
+    const atomic<bool>* cancelFlag; // 非空且被置位时，求解函数在下一次检查时放弃搜索并返回 false
+    vector<PortfolioMember> portfolio;  // 组合求解的成员，为空时使用 DefaultPortfolio()
+    int portfolioQuality;           // 组合求解接受的解的质量（PortfolioQuality）
+    double anytimeWeight;           // ARA* 第一轮的启发权重
+    double anytimeWeightStep;       // ARA* 每轮降低的权重，降到1为止
+    long long timeLimitMs;          // ARA* 的时间上限（毫秒），0 表示不限；超时返回当前最好的解
+    function<void(const vector<GameState>& path, double bound)> onSolution;  // ARA* 每得到更短的解回调一次，可为空
+    int beamWidth;                  // 束搜索每层保留的状态数
+    int beamRestarts;               // 束搜索失败后宽度翻倍重试的次数
+    int beamMaxDepth;               // 束搜索的深度上限，0 表示总水量的两倍
+    long long memoryBudgetBytes;    // 内存预算（字节），按各求解器实际分配的节点池、表与队列计量；0 表示不限
+    int memoryAction;               // 超出预算时的处理（MemoryBudgetAction）
+    size_t presolveStates;          // SolveWithAlgorithm 先用 ProveUnsolvable 判定无解，穷举至多这么多个状态；0 表示不做判定
+    function<void(const char* algorithm, int statesExplored)> onProgress;  // 进度回调，可为空
+    ProgressChannel* progressChannel;   // 非空时每 progressInterval 个状态发布一次进度快照，可由其他线程轮询
+
+    // 输出
+    vector<GameState> solutionPath;
+    AlgorithmStats stats;
+    int totalStatesExplored;
+    int maxStatesInMemory;          // 待扩展队列/栈的峰值长度
+    long long peakMemoryBytes;      // 由搜索树节点池与各表实际分配量统计的峰值内存
+    long long prunedByRule[PRUNE_RULE_COUNT];  // 各剪枝规则去掉的后继数
+    long long solvingTime;          // 求解时间（毫秒）
+    string noSolutionReason;        // 无解原因
+    StateTableStats tableStats;     // 已访问表的负载与探测统计
+    int threadsUsed;                // 实际使用的搜索线程数
+    double parallelSpeedup;         // 各线程忙碌时间之和 / 墙钟时间（串行为1）
+    bool cancelled;                 // 本次求解因 cancelFlag 被置位而中止
+    vector<AlgorithmStats> portfolioStats;  // 组合求解各成员的统计，与 portfolio 一一对应
+    int portfolioWinner;            // 结果被采用的成员下标，-1 表示没有
+    double suboptimalityBound;      // ARA*：解长 / 最优解长的上界，1 表示已证明最优；0 表示未计算
+    int beamWidthUsed;              // 束搜索最后一轮使用的宽度
+    long long externalDiskBytes;    // 外存 BFS 临时文件的峰值总大小（字节）
+    int memoryActionTaken;          // 触发内存预算后采取的处理，MEMORY_NONE 表示未触发
+
+    SolverContext() : initialEmptyTubes(0), progressInterval(100), expectedStates(0),
+        canonicalizeTubes(true), canonicalizeColors(false), pruneRules(PRUNE_ALL),
+        heuristic(HEURISTIC_BLOCKS), transpositionBytes(64u << 20), transpositionPolicy(REPLACE_DEEPER),
+        layeredBFS(false), externalBFS(false), externalMemoryBytes(256u << 20), searchThreads(1), heuristicWeight(1.0), cancelFlag(NULL), portfolioQuality(QUALITY_OPTIMAL),
+        anytimeWeight(3.0), anytimeWeightStep(0.5), timeLimitMs(0),
+        beamWidth(1000), beamRestarts(2), beamMaxDepth(0), memoryBudgetBytes(0), memoryAction(MEMORY_ABORT), presolveStates(256), progressChannel(NULL),
+        totalStatesExplored(0), maxStatesInMemory(0), peakMemoryBytes(0), solvingTime(0),
+        threadsUsed(1), parallelSpeedup(1.0), cancelled(false), portfolioWinner(-1),
+        suboptimalityBound(0.0), beamWidthUsed(0), externalDiskBytes(0), memoryActionTaken(MEMORY_NONE) {
+        tableStats = { 0, 0, 0.0, 0.0, 0, 0, 0 };
+        for (int i = 0; i < PRUNE_RULE_COUNT; i++) prunedByRule[i] = 0;
+    }
+};
+
+// ==================== 求解函数 ====================
+// 与位编码互转；超出编码范围（试管数/容量/颜色）时 packState 返回 false
+bool packState(const GameState& state, PackedState& packed);
+GameState unpackState(const PackedState& packed);
+
+// 从初始状态正向重放移动序列，得到含初始状态在内的完整路径
+void replayMoves(const GameState& start, const vector<MoveRecord>& moves, vector<GameState>& path);
+
+int countEmptyTubes(const GameState& state);
+bool isGoalState(const GameState& state, int initialEmptyTubes);
+vector<string> extractMoveSequence(const vector<GameState>& path);
+void printSolutionToConsole(const vector<GameState>& path, const string& algorithm);
+
+bool BFS_Solve(const GameState& start, SolverContext& ctx);
+bool DFS_Solve(const GameState& start, SolverContext& ctx);
+// searchThreads 大于1时为 HDA*：按状态哈希分给各线程，各线程有自己的开放表与已访问表，解仍为最优
+bool AStar_Solve(const GameState& start, SolverContext& ctx);
+// 迭代加深 A*：内存只有当前路径与固定大小的置换表，解为最优
+bool IDAStar_Solve(const GameState& start, SolverContext& ctx);
+
+// 可随时中止的加权 A*：权重从 anytimeWeight 逐轮降到1，每得到更短的解即写入 solutionPath 并回调 onSolution
+bool ARAStar_Solve(const GameState& start, SolverContext& ctx);
+// 束搜索：每层只保留启发值最小的 beamWidth 个状态，不完备、不保证最短；试管数可超过16（最多255）
+bool Beam_Solve(const GameState& start, SolverContext& ctx);
+// 组合求解：各成员在独立线程中同时求解，采用第一个满足 portfolioQuality 的结果并取消其余成员
+bool Portfolio_Solve(const GameState& start, SolverContext& ctx);
+
+// 求解前的快速无解判定：颜色计数不符、没有合法移动，或可达状态在 probeStates 个以内穷尽且都不是目标。
+// 证明无解时写入原因并返回 true；返回 false 只表示未能快速证明。statesExamined 非空时写入穷举的状态数
+bool ProveUnsolvable(const GameState& start, int initialEmptyTubes, size_t probeStates, string& reason,
+    int* statesExamined = NULL);
+
+// 按名称调用求解函数（"BFS" / "DFS" / "A*" / "IDA*" / "ARA*" / "Beam" / "Portfolio"），未知名称返回 false
+bool SolveWithAlgorithm(const string& algorithm, const GameState& start, SolverContext& ctx);
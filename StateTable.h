@@ -0,0 +1,187 @@
+﻿#pragma once
+// ==================== 开放寻址状态表 ====================
+// 以 PackedState 为键的扁平哈希表（线性探测、容量为2的幂）。
+// 每个槽位缓存哈希值，探测时先比较哈希再比较状态；
+// insertOrFind 一次探测即可完成"查找或插入"，A* 的更新也无需再次查找。
+// 键存为稠密编码（见 PackedState::encode），与哈希值相邻存放，每个槽位 1 + packedWords(n, m) 个字；
+// 同一张表的键规格相同，由第一次插入的键决定，之前只记下预分配的容量。值另存一个数组。
+#include <vector>
+#include <algorithm>
+#include <stddef.h>
+#include <string.h>
+#include "PackedState.h"
+
+using namespace std;
+
+// 表的负载与探测统计
+struct StateTableStats {
+    size_t size;             // 已存储状态数
+    size_t capacity;         // 槽位数
+    double loadFactor;       // size / capacity
+    double averageProbes;    // 每次查找平均探测槽位数
+    int maxProbes;           // 单次查找最长探测长度
+    int rehashCount;         // 扩容次数
+    size_t memoryBytes;      // 槽位数组占用字节数
+};
+
+template <typename Value>
+class StateTable {
+public:
+    explicit StateTable(size_t expectedStates = 0)
+        : stride(0), keyWords(0), slotCount(0), plannedSlots(MIN_CAPACITY), count(0), mask(0), loadNum(MAX_LOAD_NUM),
+        lookups(0), probes(0), maxProbeLength(0), rehashes(0) {
+        reserve(expectedStates);
+    }
+
+    // 按预计状态数预分配，保证插入 expectedStates 个状态前不扩容
+    void reserve(size_t expectedStates) {
+        size_t needed = MIN_CAPACITY;
+        while (needed * loadNum < expectedStates * LOAD_DEN) needed <<= 1;
+        if (keyWords == 0) plannedSlots = max(plannedSlots, needed);
+        else if (needed > slotCount) rehash(needed);
+    }
+
+    // 内存紧张时压缩：负载因子上限提高到 0.9，并收缩到满足该上限的最小容量，之后也按此上限扩容。
+    // 线性探测在高负载下未命中的探测变长，以此换取少一次翻倍
+    void compact() {
+        loadNum = COMPACT_LOAD_NUM;
+        size_t needed = MIN_CAPACITY;
+        while (needed * loadNum < (count + 1) * LOAD_DEN) needed <<= 1;
+        if (keyWords == 0) plannedSlots = needed;
+        else if (needed < slotCount) rehash(needed);
+    }
+
+    // 查找 key，不存在则以 initial 插入；返回值的指针（下次插入前有效）
+    Value* insertOrFind(const PackedState& key, const Value& initial, bool& inserted) {
+        if (keyWords == 0) setShape(key);
+        if ((count + 1) * LOAD_DEN > slotCount * loadNum) rehash(slotCount * 2);
+
+        uint64_t encoded[PACKED_MAX_TUBES];
+        key.encode(encoded);
+        uint64_t h = slotHash(key);
+        size_t index = (size_t)h & mask;
+        int probeLength = 1;
+        while (slots[index * stride] != 0) {
+            if (matches(index, h, encoded)) {
+                recordProbe(probeLength);
+                inserted = false;
+                return &values[index];
+            }
+            index = (index + 1) & mask;
+            probeLength++;
+        }
+        recordProbe(probeLength);
+
+        uint64_t* slot = &slots[index * stride];
+        slot[0] = h;
+        memcpy(slot + 1, encoded, keyWords * sizeof(uint64_t));
+        values[index] = initial;
+        count++;
+        inserted = true;
+        return &values[index];
+    }
+
+    // 查找 key，不存在返回 NULL
+    Value* find(const PackedState& key) {
+        if (keyWords == 0) return NULL;
+        uint64_t encoded[PACKED_MAX_TUBES];
+        key.encode(encoded);
+        uint64_t h = slotHash(key);
+        size_t index = (size_t)h & mask;
+        int probeLength = 1;
+        while (slots[index * stride] != 0) {
+            if (matches(index, h, encoded)) {
+                recordProbe(probeLength);
+                return &values[index];
+            }
+            index = (index + 1) & mask;
+            probeLength++;
+        }
+        recordProbe(probeLength);
+        return NULL;
+    }
+
+    bool contains(const PackedState& key) { return find(key) != NULL; }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slotCount; }
+    double loadFactor() const { return slotCount == 0 ? 0.0 : (double)count / slotCount; }
+
+    StateTableStats stats() const {
+        StateTableStats s;
+        s.size = count;
+        s.capacity = slotCount;
+        s.loadFactor = loadFactor();
+        s.averageProbes = lookups == 0 ? 0.0 : (double)probes / lookups;
+        s.maxProbes = maxProbeLength;
+        s.rehashCount = rehashes;
+        s.memoryBytes = slots.size() * sizeof(uint64_t) + values.size() * sizeof(Value);
+        return s;
+    }
+
+private:
+    // 最大负载因子 loadNum / LOAD_DEN，压缩后为 COMPACT_LOAD_NUM / LOAD_DEN
+    static const size_t MAX_LOAD_NUM = 7;
+    static const size_t COMPACT_LOAD_NUM = 9;
+    static const size_t LOAD_DEN = 10;
+    static const size_t MIN_CAPACITY = 1024;
+
+    vector<uint64_t> slots;     // 每个槽位：哈希值（0 表示空槽）+ 稠密编码的键
+    vector<Value> values;
+    size_t stride;              // 每个槽位的字数
+    int keyWords;
+    size_t slotCount;
+    size_t plannedSlots;        // 键规格确定前记下的预分配槽位数
+    size_t count;
+    size_t mask;
+    size_t loadNum;
+    unsigned long long lookups;
+    unsigned long long probes;
+    int maxProbeLength;
+    int rehashes;
+
+    // 保留 0 作为空槽标记
+    static uint64_t slotHash(const PackedState& key) {
+        uint64_t h = key.hash();
+        return h == 0 ? 1 : h;
+    }
+
+    bool matches(size_t index, uint64_t h, const uint64_t* encoded) const {
+        const uint64_t* slot = &slots[index * stride];
+        return slot[0] == h && memcmp(slot + 1, encoded, keyWords * sizeof(uint64_t)) == 0;
+    }
+
+    void setShape(const PackedState& key) {
+        keyWords = key.words();
+        stride = 1 + keyWords;
+        rehash(plannedSlots);
+    }
+
+    void recordProbe(int probeLength) {
+        lookups++;
+        probes += probeLength;
+        if (probeLength > maxProbeLength) maxProbeLength = probeLength;
+    }
+
+    void rehash(size_t newCapacity) {
+        vector<uint64_t> oldSlots;
+        vector<Value> oldValues;
+        oldSlots.swap(slots);
+        oldValues.swap(values);
+        size_t oldCount = slotCount;
+        slots.assign(newCapacity * stride, 0);
+        values.assign(newCapacity, Value());
+        slotCount = newCapacity;
+        mask = newCapacity - 1;
+        if (oldCount > 0) rehashes++;
+
+        for (size_t i = 0; i < oldCount; i++) {
+            const uint64_t* old = &oldSlots[i * stride];
+            if (old[0] == 0) continue;
+            size_t index = (size_t)old[0] & mask;
+            while (slots[index * stride] != 0) index = (index + 1) & mask;
+            memcpy(&slots[index * stride], old, stride * sizeof(uint64_t));
+            values[index] = oldValues[i];
+        }
+    }
+};
@@ -0,0 +1,157 @@
+﻿#pragma once
+// ==================== IDA* 置换表 ====================
+// 固定大小、按内存预算分配的组相联表：每个桶4个条目，表满后按替换策略淘汰，永不扩容。
+// 条目记录状态在本轮迭代中被展开时的 g 值；轮次号不同的条目视为空槽，
+// 因此开始新一轮只需递增轮次号，不必清表。
+// 同一轮中再次以不小于已记录 g 的代价到达某状态时，其子树已在更宽的剩余预算下搜索过，可直接剪掉。
+// 键按稠密编码另存一个数组（每个条目 keyWords 个字），只在哈希相同时才读取，预算内能放下的条目数随关卡规格变化。
+#include <new>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PackedState.h"
+#include "StateTable.h"
+
+using namespace std;
+
+enum TableReplacePolicy {
+    REPLACE_DEEPER = 0,     // 桶满时淘汰 g 最大（子树最小）的条目；新条目更深则不存
+    REPLACE_ALWAYS,         // 桶满时总是覆盖哈希决定的那个条目
+    REPLACE_POLICY_COUNT
+};
+
+class TranspositionTable {
+public:
+    // keyWords 为键的稠密编码字数（PackedState::words）
+    TranspositionTable(size_t budgetBytes, int replacePolicy, int keyWords)
+        : words(keyWords), policy(replacePolicy), iteration(0), stored(0), lookups(0), probes(0), evictions(0), dropped(0) {
+        size_t entryBytes = sizeof(Entry) + words * sizeof(uint64_t);
+        size_t buckets = 1;
+        while ((buckets * 2) * BUCKET_SIZE * entryBytes <= budgetBytes) buckets <<= 1;
+        // calloc 的大块内存由系统按页惰性清零，只触及实际用到的桶，简单关卡不必先清空整个预算
+        entryCount = buckets * BUCKET_SIZE;
+        entries = (Entry*)calloc(entryCount, sizeof(Entry));
+        keys = (uint64_t*)calloc(entryCount * words, sizeof(uint64_t));
+        if (entries == NULL || keys == NULL) {
+            free(entries);
+            free(keys);
+            throw bad_alloc();
+        }
+        mask = buckets - 1;
+    }
+
+    ~TranspositionTable() {
+        free(entries);
+        free(keys);
+    }
+
+    // 开始新一轮迭代，旧条目全部失效
+    void newIteration() {
+        iteration++;
+        stored = 0;
+        evictions = 0;
+        dropped = 0;
+    }
+
+    // 本轮是否已以不大于 g 的代价展开过 key
+    bool seenWithin(const PackedState& key, int g) {
+        uint64_t h = key.hash();
+        size_t first = (h & mask) * BUCKET_SIZE;
+        uint64_t encoded[PACKED_MAX_TUBES];
+        key.encode(encoded);
+        lookups++;
+        for (size_t i = first; i < first + BUCKET_SIZE; i++) {
+            probes++;
+            const Entry& e = entries[i];
+            if (e.iteration == iteration && e.hash == h && sameKey(i, encoded)) return e.g <= g;
+        }
+        return false;
+    }
+
+    // 记录本轮以代价 g 展开了 key
+    void store(const PackedState& key, int g) {
+        uint64_t h = key.hash();
+        size_t first = (h & mask) * BUCKET_SIZE;
+        Entry* bucket = &entries[first];
+        uint64_t encoded[PACKED_MAX_TUBES];
+        key.encode(encoded);
+
+        Entry* target = NULL;
+        for (int i = 0; i < BUCKET_SIZE; i++) {
+            Entry& e = bucket[i];
+            if (e.iteration == iteration && e.hash == h && sameKey(first + i, encoded)) {
+                if (g < e.g) e.g = g;
+                return;
+            }
+            if (target == NULL && e.iteration != iteration) target = &e;
+        }
+
+        if (target == NULL) {
+            if (policy == REPLACE_ALWAYS) {
+                target = &bucket[(h >> 32) % BUCKET_SIZE];
+            }
+            else {
+                target = &bucket[0];
+                for (int i = 1; i < BUCKET_SIZE; i++) {
+                    if (bucket[i].g > target->g) target = &bucket[i];
+                }
+                if (target->g <= g) {
+                    dropped++;
+                    return;
+                }
+            }
+            evictions++;
+            stored--;
+        }
+
+        target->hash = h;
+        memcpy(&keys[(first + (target - bucket)) * words], encoded, words * sizeof(uint64_t));
+        target->g = g;
+        target->iteration = iteration;
+        stored++;
+    }
+
+    size_t memoryBytes() const { return entryCount * (sizeof(Entry) + words * sizeof(uint64_t)); }
+
+    StateTableStats stats() const {
+        StateTableStats s;
+        s.size = stored;
+        s.capacity = entryCount;
+        s.loadFactor = entryCount == 0 ? 0.0 : (double)stored / entryCount;
+        s.averageProbes = lookups == 0 ? 0.0 : (double)probes / lookups;
+        s.maxProbes = BUCKET_SIZE;
+        s.rehashCount = 0;
+        s.memoryBytes = memoryBytes();
+        return s;
+    }
+
+private:
+    // 全零即为空条目
+    struct Entry {
+        uint64_t hash;
+        int g;
+        unsigned iteration;     // 0 表示从未使用
+    };
+
+    static const int BUCKET_SIZE = 4;
+
+    bool sameKey(size_t entry, const uint64_t* encoded) const {
+        return memcmp(&keys[entry * words], encoded, words * sizeof(uint64_t)) == 0;
+    }
+
+    TranspositionTable(const TranspositionTable&);
+    TranspositionTable& operator=(const TranspositionTable&);
+
+    Entry* entries;
+    uint64_t* keys;             // 第 i 个条目的键占 keys[i*words, (i+1)*words)
+    size_t entryCount;
+    int words;
+    size_t mask;
+    int policy;
+    unsigned iteration;
+    size_t stored;
+    unsigned long long lookups;
+    unsigned long long probes;
+    long long evictions;
+    long long dropped;
+};
@@ -0,0 +1,308 @@
+﻿#pragma once
+// ==================== 宽状态编码 ====================
+// 供束搜索处理超出 PackedState 范围（16个试管、容量16、15种颜色）的大关卡。
+// 每格一个字节：第 i 个试管占 cells[i*capacity, (i+1)*capacity)，自底向上，0 表示空格；
+// 各试管高度另存于 sizes。WideState 只用作展开时的工作状态，成批的状态存放在 WideStateArray 中，
+// 去重键存放在 WideKeySet 中，都是定长记录连续排列，不为每个状态分配内存。
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+const int WIDE_MAX_TUBES = 255;     // 移动记录用一个字节保存试管号
+const int WIDE_MAX_CAPACITY = 255;
+const int WIDE_MAX_COLOR = 255;
+
+struct WideState {
+    int numTubes;
+    int capacity;
+    vector<uint8_t> cells;
+    vector<uint8_t> sizes;
+
+    WideState() : numTubes(0), capacity(0) {}
+
+    void reset(int tubes, int cap) {
+        numTubes = tubes;
+        capacity = cap;
+        cells.assign((size_t)tubes * cap, 0);
+        sizes.assign(tubes, 0);
+    }
+
+    // 在试管顶部放入一格颜色（构造状态用）
+    void push(int tube, int color) {
+        cells[(size_t)tube * capacity + sizes[tube]] = (uint8_t)color;
+        sizes[tube]++;
+    }
+
+    int tubeSize(int i) const { return sizes[i]; }
+    bool isEmpty(int i) const { return sizes[i] == 0; }
+    bool isFull(int i) const { return sizes[i] >= capacity; }
+    int colorAt(int i, int j) const { return cells[(size_t)i * capacity + j]; }
+    int topColor(int i) const { return sizes[i] == 0 ? 0 : colorAt(i, sizes[i] - 1); }
+
+    // 顶部连续同色的格数
+    int topSegmentSize(int i) const {
+        int size = sizes[i];
+        if (size == 0) return 0;
+        const uint8_t* tube = &cells[(size_t)i * capacity];
+        int count = 1;
+        while (count < size && tube[size - 1 - count] == tube[size - 1]) count++;
+        return count;
+    }
+
+    // 空或只有一种颜色（与 PackedState::isComplete 相同）
+    bool isComplete(int i) const { return topSegmentSize(i) == sizes[i]; }
+
+    int firstEmptyTube() const {
+        for (int i = 0; i < numTubes; i++) {
+            if (sizes[i] == 0) return i;
+        }
+        return -1;
+    }
+
+    // from 倒入 to 的水量，0 表示不能倒
+    int pourAmount(int from, int to) const {
+        if (from == to || sizes[from] == 0 || sizes[to] >= capacity) return 0;
+        if (sizes[to] > 0 && topColor(to) != topColor(from)) return 0;
+        return min(topSegmentSize(from), capacity - (int)sizes[to]);
+    }
+
+    void applyPour(int from, int to, int amount) {
+        int color = topColor(from);
+        uint8_t* source = &cells[(size_t)from * capacity];
+        uint8_t* target = &cells[(size_t)to * capacity];
+        for (int k = 0; k < amount; k++) {
+            source[sizes[from] - 1 - k] = 0;
+            target[sizes[to] + k] = (uint8_t)color;
+        }
+        sizes[from] = (uint8_t)(sizes[from] - amount);
+        sizes[to] = (uint8_t)(sizes[to] + amount);
+    }
+
+    // 与 HEURISTIC_BLOCKS 相同：异色底上的色块数 + 各颜色多余的底块数
+    int blockHeuristic() const {
+        int changes = 0;
+        int bottoms[WIDE_MAX_COLOR + 1] = { 0 };
+        int surplus = 0;
+        for (int i = 0; i < numTubes; i++) {
+            int size = sizes[i];
+            if (size == 0) continue;
+            const uint8_t* tube = &cells[(size_t)i * capacity];
+            for (int j = 1; j < size; j++) {
+                if (tube[j] != tube[j - 1]) changes++;
+            }
+            if (bottoms[tube[0]]++ > 0) surplus++;
+        }
+        return changes + surplus;
+    }
+
+    // 每个非空试管单色、各颜色只在一个试管中、空试管数与初始相同
+    bool isGoal(int initialEmptyTubes) const {
+        bool used[WIDE_MAX_COLOR + 1] = { false };
+        int empty = 0;
+        for (int i = 0; i < numTubes; i++) {
+            if (sizes[i] == 0) {
+                empty++;
+                continue;
+            }
+            if (!isComplete(i)) return false;
+            int color = colorAt(i, 0);
+            if (used[color]) return false;
+            used[color] = true;
+        }
+        return empty == initialEmptyTubes;
+    }
+};
+
+// 定长记录的宽状态数组：每个状态占 试管数 × (容量 + 1) 字节（各格颜色后接各试管高度），全部连续存放
+class WideStateArray {
+public:
+    WideStateArray() : numTubes(0), capacity(0), stride(0) {}
+
+    void reset(int tubes, int cap) {
+        numTubes = tubes;
+        capacity = cap;
+        stride = (size_t)tubes * (cap + 1);
+        bytes.clear();
+    }
+
+    size_t size() const { return stride == 0 ? 0 : bytes.size() / stride; }
+    void clear() { bytes.clear(); }
+    void swap(WideStateArray& other) { bytes.swap(other.bytes); }
+    size_t memoryBytes() const { return bytes.capacity(); }
+
+    void push(const WideState& state) {
+        size_t at = bytes.size();
+        bytes.resize(at + stride);
+        memcpy(&bytes[at], &state.cells[0], state.cells.size());
+        memcpy(&bytes[at + state.cells.size()], &state.sizes[0], state.sizes.size());
+    }
+
+    // 追加 other 的第 i 个状态（两者试管数、容量相同）
+    void pushFrom(const WideStateArray& other, size_t i) {
+        size_t at = bytes.size();
+        bytes.resize(at + stride);
+        memcpy(&bytes[at], &other.bytes[i * stride], stride);
+    }
+
+    // 取出第 i 个状态；out 的缓冲区尺寸不变时不重新分配
+    void load(size_t i, WideState& out) const {
+        if (out.numTubes != numTubes || out.capacity != capacity) out.reset(numTubes, capacity);
+        const uint8_t* record = &bytes[i * stride];
+        memcpy(&out.cells[0], record, out.cells.size());
+        memcpy(&out.sizes[0], record + out.cells.size(), out.sizes.size());
+    }
+
+private:
+    int numTubes;
+    int capacity;
+    size_t stride;
+    vector<uint8_t> bytes;
+};
+
+// 生成宽状态的去重键（试管数 × 容量 字节），语义同 PackedState::symmetryReduced：
+// canonicalTubes 时按字节序排序试管，canonicalColors 时按首次出现顺序重标号颜色（两者都开时先排序、再重标号、再排序）。
+// 排序用的缓冲区在各次调用间复用
+class WideKeyEncoder {
+public:
+    WideKeyEncoder(bool canonicalTubes, bool canonicalColors) : tubeOrder(canonicalTubes), colorLabels(canonicalColors) {}
+
+    void encode(const WideState& state, uint8_t* out) {
+        size_t bytes = state.cells.size();
+        const uint8_t* source = &state.cells[0];
+        if (!colorLabels) {
+            if (tubeOrder) sortTubes(source, state.numTubes, state.capacity, out);
+            else memcpy(out, source, bytes);
+            return;
+        }
+
+        buffer.resize(bytes);
+        if (tubeOrder) {
+            sortTubes(source, state.numTubes, state.capacity, &buffer[0]);
+            source = &buffer[0];
+        }
+        uint8_t* target = tubeOrder ? &buffer[0] : out;
+        uint8_t relabel[WIDE_MAX_COLOR + 1] = { 0 };
+        int nextColor = 1;
+        for (size_t i = 0; i < bytes; i++) {
+            int color = source[i];
+            if (color != 0 && relabel[color] == 0) relabel[color] = (uint8_t)nextColor++;
+            target[i] = relabel[color];
+        }
+        if (tubeOrder) sortTubes(&buffer[0], state.numTubes, state.capacity, out);
+    }
+
+private:
+    void sortTubes(const uint8_t* cells, int numTubes, int capacity, uint8_t* out) {
+        order.resize(numTubes);
+        for (int i = 0; i < numTubes; i++) order[i] = i;
+        sort(order.begin(), order.end(), [cells, capacity](int a, int b) {
+            return memcmp(cells + (size_t)a * capacity, cells + (size_t)b * capacity, capacity) < 0;
+        });
+        for (int i = 0; i < numTubes; i++) {
+            memcpy(out + (size_t)i * capacity, cells + (size_t)order[i] * capacity, capacity);
+        }
+    }
+
+    bool tubeOrder;
+    bool colorLabels;
+    vector<int> order;
+    vector<uint8_t> buffer;
+};
+
+// 定长字节串键的哈希集合（线性探测、容量为2的幂）。
+// 键按插入顺序连续存放，第 i 个插入的键可用 keyAt(i) 取回；槽位只存哈希与键的下标。
+class WideKeySet {
+public:
+    explicit WideKeySet(size_t keyBytes = 0) : width(keyBytes), count(0) {
+        slots.resize(MIN_CAPACITY);
+    }
+
+    void reset(size_t keyBytes) {
+        width = keyBytes;
+        clear();
+    }
+
+    // 清空但保留已分配的内存
+    void clear() {
+        keys.clear();
+        fill(slots.begin(), slots.end(), Slot());
+        count = 0;
+    }
+
+    size_t size() const { return count; }
+    const uint8_t* keyAt(size_t i) const { return &keys[i * width]; }
+    size_t memoryBytes() const { return keys.capacity() + slots.capacity() * sizeof(Slot); }
+
+    bool contains(const uint8_t* key) const {
+        return slots[locate(key, hashOf(key))].index != 0;
+    }
+
+    // 插入 key，已存在时返回 false
+    bool insert(const uint8_t* key) {
+        if ((count + 1) * LOAD_DEN > slots.size() * MAX_LOAD_NUM) grow();
+        uint32_t h = hashOf(key);
+        Slot& slot = slots[locate(key, h)];
+        if (slot.index != 0) return false;
+        keys.insert(keys.end(), key, key + width);
+        slot.hash = h;
+        slot.index = (uint32_t)++count;
+        return true;
+    }
+
+private:
+    struct Slot {
+        uint32_t hash;
+        uint32_t index;     // 键下标 + 1，0 表示空槽
+
+        Slot() : hash(0), index(0) {}
+    };
+
+    static const size_t MAX_LOAD_NUM = 7;
+    static const size_t LOAD_DEN = 10;
+    static const size_t MIN_CAPACITY = 1024;
+
+    size_t width;
+    size_t count;
+    vector<uint8_t> keys;
+    vector<Slot> slots;
+
+    uint32_t hashOf(const uint8_t* key) const {
+        uint64_t h = 0x9E3779B97F4A7C15ULL ^ width;
+        size_t i = 0;
+        for (; i < width; i += 8) {
+            uint64_t word = 0;
+            memcpy(&word, key + i, min((size_t)8, width - i));
+            h = (h ^ word) * 0xFF51AFD7ED558CCDULL;
+            h ^= h >> 32;
+        }
+        h ^= h >> 29;
+        return (uint32_t)h;
+    }
+
+    // key 所在的槽位，不存在时为应插入的空槽
+    size_t locate(const uint8_t* key, uint32_t h) const {
+        size_t mask = slots.size() - 1;
+        size_t index = h & mask;
+        while (slots[index].index != 0) {
+            if (slots[index].hash == h && memcmp(keyAt(slots[index].index - 1), key, width) == 0) return index;
+            index = (index + 1) & mask;
+        }
+        return index;
+    }
+
+    void grow() {
+        vector<Slot> old;
+        old.swap(slots);
+        slots.resize(old.size() * 2);
+        size_t mask = slots.size() - 1;
+        for (size_t i = 0; i < old.size(); i++) {
+            if (old[i].index == 0) continue;
+            size_t index = old[i].hash & mask;
+            while (slots[index].index != 0) index = (index + 1) & mask;
+            slots[index] = old[i];
+        }
+    }
+};